@@ -18,6 +18,29 @@
 
 
 
+/**
+ * \brief	How the application finds the widget under the mouse pointer.
+ */
+typedef enum {
+	ei_picking_offscreen	= 0,	///< Widgets draw their pick color in an offscreen surface of the size of the root window (default).
+	ei_picking_geometric,		///< No offscreen: a spatial index of the screen locations is walked from top to bottom, with exact shape tests.
+	ei_picking_compact,		///< A buffer of 16 bits pick ids, filled from the shapes of the widgets (half the memory of the offscreen).
+	ei_picking_compact_half		///< Same as ei_picking_compact at half the resolution: cells shared by several widgets are refined geometrically (1/8 of the memory of the offscreen).
+} ei_picking_mode_t;
+
+
+
+/**
+ * \brief	Selects the picking mode of the application. Must be called before
+ *		\ref ei_app_create, which allocates what the mode needs.
+ *		The other modes do not allocate the pick surface (4 bytes per pixel of the
+ *		root window): in these modes, the "pick_surface" parameter of the draw functions
+ *		is NULL.
+ *
+ * @param	mode		The picking mode. Defaults to \ref ei_picking_offscreen.
+ */
+void ei_app_set_picking_mode(ei_picking_mode_t mode);
+
 /**
  * \brief	Creates an application.
  *		<ul>
@@ -25,7 +48,8 @@
  *			<li> registers all classes of widget and all geometry managers, </li>
  *			<li> creates the root window (either in a system window, or the entire
  *				screen), </li>
- *			<li> creates the root widget to access the root window. </li>
+ *			<li> creates the root widget to access the root window, </li>
+ *			<li> initializes picking in the mode set by \ref ei_app_set_picking_mode. </li>
  *		</ul>
  *
  * @param	main_window_size	If "fullscreen is false, the size of the root window of the
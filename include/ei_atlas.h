@@ -0,0 +1,88 @@
+/**
+ *  @file	ei_atlas.h
+ *  @brief	Atlases: many small images packed in one surface (skyline packing), used by the
+ *		widgets through the rectangle of each image.
+ *
+ */
+
+#ifndef EI_ATLAS_H
+#define EI_ATLAS_H
+
+#include "ei_types.h"
+#include "hw_interface.h"
+
+
+/* empty pixels around each image of an atlas, so that filtered drawings do not bleed */
+#define EI_ATLAS_PADDING	1
+
+
+/**
+ * \brief	An atlas, built by adding images then packing them with \ref ei_atlas_build.
+ */
+typedef struct ei_atlas_t {
+	ei_surface_t	surface;	///< The surface holding the images (NULL until built).
+	ei_surface_t*	images;		///< The images added (released when the atlas is built).
+	ei_rect_t*	rects;		///< The rectangle of each image in the surface.
+	int		images_nb;	///< Number of images.
+	int		images_size;	///< Allocated size of images and rects.
+} ei_atlas_t;
+
+
+/**
+ * \brief	Creates an empty atlas.
+ *
+ * @return	The atlas, to free with \ref ei_atlas_free.
+ */
+ei_atlas_t*	ei_atlas_create		(void);
+
+
+/**
+ * \brief	Adds an image to an atlas that is not built yet.
+ *
+ * @param	atlas		The atlas.
+ * @param	image		The image (a reference is held until the atlas is built).
+ * @return	The index of the image in the atlas.
+ */
+int		ei_atlas_add		(ei_atlas_t* atlas, ei_surface_t image);
+
+
+/**
+ * \brief	Loads an image file (see \ref ei_image_load) and adds it to an atlas.
+ *
+ * @param	atlas		The atlas.
+ * @param	filename	The name of the image file.
+ * @return	The index of the image in the atlas, -1 if the file could not be loaded.
+ */
+int		ei_atlas_add_file	(ei_atlas_t* atlas, const char* filename);
+
+
+/**
+ * \brief	Packs the images of an atlas in one surface, in the channel order of the root
+ *		surface, and releases them.
+ *
+ * @param	atlas		The atlas.
+ * @return	EI_FALSE if the atlas has no image or the surface could not be created.
+ */
+ei_bool_t	ei_atlas_build		(ei_atlas_t* atlas);
+
+
+/**
+ * \brief	Returns the rectangle of an image in the surface of a built atlas. The widgets
+ *		show it with img = atlas->surface and img_rect = this rectangle.
+ *
+ * @param	atlas		The atlas.
+ * @param	index		The index returned by \ref ei_atlas_add.
+ * @return	The rectangle, owned by the atlas.
+ */
+ei_rect_t*	ei_atlas_rect		(ei_atlas_t* atlas, int index);
+
+
+/**
+ * \brief	Frees an atlas. The widgets showing its images keep the surface alive.
+ *
+ * @param	atlas		The atlas.
+ */
+void		ei_atlas_free		(ei_atlas_t* atlas);
+
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ *  @file	ei_batch.h
+ *  @brief	Batches of updates of the widgets: between \ref ei_batch_begin and
+ *		\ref ei_batch_commit, the placement of the widgets and the rectangles to redraw
+ *		are recorded instead of being computed at each call, and resolved once at the end.
+ *
+ */
+
+#ifndef EI_BATCH_H
+#define EI_BATCH_H
+
+#include "ei_types.h"
+#include "ei_widget.h"
+
+
+/* number of rectangles to redraw kept apart in a batch: beyond, they are merged in their
+   bounding box */
+#define EI_BATCH_MAX_DAMAGE	32
+
+
+/**
+ * \brief	Starts a batch of updates (creations, configurations, placements of widgets).
+ *		Until the matching \ref ei_batch_commit, the geometry managers do not compute
+ *		the geometry of the widgets (so their geomnotifyfunc is not called either),
+ *		and the rectangles to redraw are merged. Batches can be nested: only the
+ *		outermost one is resolved.
+ */
+void		ei_batch_begin			(void);
+
+
+/**
+ * \brief	Ends a batch: computes the geometry of each widget placed or configured during
+ *		the batch once, parents first (their geomnotifyfunc computes their children,
+ *		which are then skipped), then invalidates the merged rectangles.
+ */
+void		ei_batch_commit			(void);
+
+
+/**
+ * \brief	Records that the geometry of a widget must be computed at the end of the batch.
+ *		Called by the geometry managers before computing the geometry of a widget.
+ *
+ * @param	widget		The widget.
+ * @return	EI_TRUE if a batch is open (the geometry must not be computed now), EI_FALSE
+ *		otherwise.
+ */
+ei_bool_t	ei_batch_defer_layout		(ei_widget_t* widget);
+
+
+/**
+ * \brief	Records a rectangle to redraw at the end of the batch. Called by
+ *		\ref ei_app_invalidate_rect. The rectangles contained in another one are dropped.
+ *
+ * @param	rect		The rectangle, clipped to the root window.
+ * @return	EI_TRUE if a batch is open (the rectangle must not be invalidated now), EI_FALSE
+ *		otherwise.
+ */
+ei_bool_t	ei_batch_defer_invalidate	(const ei_rect_t* rect);
+
+
+/**
+ * \brief	Forgets an open batch and frees its lists. Called by \ref ei_app_free.
+ */
+void		ei_batch_free			(void);
+
+
+#endif
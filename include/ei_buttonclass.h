@@ -10,6 +10,9 @@
 #include "ei_widget.h"
 #include "ei_widgetclass.h"
 #include "ei_event.h"
+#include "ei_surface.h"
+#include "ei_scale.h"
+#include "ei_frameclass.h"
 
 
 /**
@@ -20,25 +23,25 @@ typedef char 		ei_widget_text_t[40];
 
 /**
  * \brief	The button widget class
- *      attributes are pointers (excpet 'widget' for polymorphism): 
- *      we can know if an attribute has been 
- *      initialised before by testing if it is NULL
+ *      attributes are stored in the button itself (a single allocation by button):
+ *      the optional ones are valid only if their bit (see \ref ei_attr_t) is set in 'set'
  */
 typedef struct ei_button_t {
     ei_widget_t        widget;
-    ei_color_t*        color;
-    int*               border_width;
-    int*               corner_radius;
-    ei_relief_t*       relief;
-    ei_widget_text_t*  text;
-    ei_font_t*         text_font;
-    ei_color_t*        text_color;
-    ei_anchor_t*       text_anchor;
-    ei_surface_t*      img;
-    ei_rect_t*         img_rect;
-    ei_anchor_t*       img_anchor;
-    ei_callback_t*     callback;
-    void**             user_param;
+    unsigned           set;
+    ei_color_t         color;
+    int                border_width;
+    int                corner_radius;
+    ei_relief_t        relief;
+    ei_widget_text_t   text;
+    ei_font_t          text_font;
+    ei_color_t         text_color;
+    ei_anchor_t        text_anchor;
+    ei_surface_view_t  img;
+    ei_anchor_t        img_anchor;
+    ei_image_scaling_t img_scaling;
+    ei_callback_t      callback;
+    void*              user_param;
     ei_bool_t          no_clipping;
     ei_bool_t          is_quit_button;
     ei_bool_t          is_resize_button;
@@ -71,6 +74,7 @@ void		releasebutton	(struct ei_widget_t*	widget);
  * @param	surface		Where to draw the widget. The actual location of the widget in the
  *				surface is stored in its "screen_location" field.
  * @param	pick_surface	The surface used for picking (i.e. find the widget below the mouse pointer).
+ *				NULL unless the application uses \ref ei_picking_offscreen.
  * @param	clipper		If not NULL, the drawing is restricted within this rectangle
  *				(expressed in the surface reference button).
  */
@@ -52,6 +52,16 @@ void ei_free_linked_points_list(ei_linked_point_t *list);
 ei_rect_t get_ei_rect_intersection(ei_rect_t rect1, ei_rect_t rect2);
 
 
+/**
+ * \brief Computes the smallest rect containing 2 ei_rect_t.
+ * 
+ * @param rect1 The first rect (ignored if it is empty).
+ * @param rect2 The other rect (ignored if it is empty).
+ * @return The bounding rect.
+ */
+ei_rect_t get_ei_rect_union(ei_rect_t rect1, ei_rect_t rect2);
+
+
 /**
  * \brief Makes a ei_rect_t keep its boundaries into the screen
  * 
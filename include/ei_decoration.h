@@ -0,0 +1,53 @@
+/**
+ *  @file	ei_decoration.h
+ *  @brief	Cache of the rendered decorations of the frames and buttons (the relief around the
+ *		content): the corners are rasterized once for each corner radius, border width,
+ *		relief and color, then a decoration is drawn by copying its 4 corners and filling
+ *		the rectangles of its edges and of its center.
+ *
+ */
+
+#ifndef EI_DECORATION_H
+#define EI_DECORATION_H
+
+#include "ei_types.h"
+#include "hw_interface.h"
+
+
+/* maximum number of decorations kept in the cache */
+#define EI_DECORATION_CACHE_ENTRIES	64
+
+
+/**
+ * \brief	Draws the decoration of a frame or of a button: the border, lightened or darkened
+ *		depending on the relief, and the content filled with the color. The corners are
+ *		rendered if they are not in the cache. The least recently used decoration is
+ *		evicted when the cache is full.
+ *
+ * @param	surface		Where to draw the decoration.
+ * @param	rect		The location of the widget in the surface.
+ * @param	corner_radius	The radius of the corners.
+ * @param	border_width	The width of the border.
+ * @param	relief		The relief.
+ * @param	color		The color of the widget, which must be opaque.
+ * @param	clipper		The drawing is restricted within this rectangle.
+ * @return	EI_FALSE if the decoration can't be drawn from its corners (the color isn't
+ *		opaque, there is no border, or the widget is too small for its corners): it must
+ *		then be drawn with polygons.
+ */
+ei_bool_t	ei_decoration_draw	(ei_surface_t		surface,
+					 ei_rect_t		rect,
+					 int			corner_radius,
+					 int			border_width,
+					 ei_relief_t		relief,
+					 ei_color_t		color,
+					 const ei_rect_t*	clipper);
+
+
+/**
+ * \brief	Empties the cache. Called by \ref ei_app_free.
+ */
+void		ei_decoration_cache_free(void);
+
+
+#endif
@@ -15,6 +15,8 @@
 #include <stdint.h>
 #include "ei_types.h"
 #include "hw_interface.h"
+#include "ei_surface.h"
+#include "ei_scale.h"
 
 
 
@@ -28,7 +30,8 @@
  *
  * @return 			The 32 bit integer corresponding to the color. The alpha component
  *				of the color is ignored in the case of surfaces that don't have an
- *				alpha channel.
+ *				alpha channel. On premultiplied surfaces, the red, green and blue
+ *				components are multiplied by the alpha component.
  */
 uint32_t		ei_map_rgba		(ei_surface_t surface, const ei_color_t* color);
 
@@ -69,7 +72,8 @@ void			ei_draw_polygon		(ei_surface_t			surface,
 						 const ei_rect_t*		clipper);
 
 /**
- * \brief	Draws text by calling \ref hw_text_create_surface.
+ * \brief	Draws text by calling \ref hw_text_create_surface. The coverage of the glyphs is
+ *		rendered once for each text and font, and cached (see \ref ei_text_cache_get).
  *
  * @param	surface 	Where to draw the text. The surface must be *locked* by
  *				\ref hw_surface_lock.
@@ -88,6 +92,15 @@ void			ei_draw_text		(ei_surface_t		surface,
 						 ei_color_t		color,
 						 const ei_rect_t*	clipper);
 
+/**
+ * \brief	Frees a font created by \ref hw_text_font_create, and the texts rendered with it
+ *		in the cache of \ref ei_draw_text (a new font may then be allocated at the same
+ *		address). Must be used instead of \ref hw_text_font_free.
+ *
+ * @param	font		The font.
+ */
+void			ei_font_free		(ei_font_t		font);
+
 /**
  * \brief	Fills the surface with the specified color.
  *
@@ -118,6 +131,9 @@ void			ei_fill			(ei_surface_t		surface,
  * @param	alpha		If true, the final pixels are a combination of source and
  *				destination pixels weighted by the source alpha channel. The
  *				transparency of the final pixels is set	to opaque.
+ *				If one of the surfaces is premultiplied (see
+ *				\ref ei_surface_set_premultiplied), the source is composed
+ *				"over" the destination instead, and so are the alpha channels.
  *				If false, the final pixels are an exact copy of the source pixels,
  				including the alpha channel.
  *
@@ -130,6 +146,41 @@ int			ei_copy_surface		(ei_surface_t		destination,
 						 const ei_bool_t	alpha);
 
 
+/**
+ * \brief	Same as \ref ei_copy_surface, between two descriptors (see \ref ei_surface_desc
+ *		and \ref ei_surface_view_desc): the rectangles are relative to the descriptors.
+ *
+ * @return			Returns 0 on success, 1 on failure (different ROI size).
+ */
+int			ei_copy_desc		(const ei_surface_desc_t*	dst,
+						 const ei_rect_t*		dst_rect,
+						 const ei_surface_desc_t*	src,
+						 const ei_rect_t*		src_rect,
+						 const ei_bool_t		alpha);
+
+
+/**
+ * \brief	Same as \ref ei_copy_surface, scaling the source rectangle to the destination
+ *		rectangle (their sizes may differ).
+ *
+ * @param	destination, dst_rect, source, src_rect, alpha
+ *				See \ref ei_copy_surface.
+ * @param	filter		The filter used to scale the source (\ref ei_filter_nearest or
+ *				\ref ei_filter_bilinear).
+ * @param	clipper		If not NULL, the drawing is restricted within this rectangle.
+ *
+ * @return			Returns 0 on success, 1 on failure (empty source rectangle, or not
+ *				enough memory).
+ */
+int			ei_copy_surface_scaled	(ei_surface_t		destination,
+						 const ei_rect_t*	dst_rect,
+						 const ei_surface_t	source,
+						 const ei_rect_t*	src_rect,
+						 const ei_bool_t	alpha,
+						 ei_filter_t		filter,
+						 const ei_rect_t*	clipper);
+
+
 
 
 #endif
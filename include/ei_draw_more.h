@@ -62,6 +62,18 @@ ei_linked_point_t* ei_rounded_frame_low(ei_rect_t rect, int r);
 ei_linked_point_t* ei_rounded_frame_all(ei_rect_t rect, int r);
 
 
+/**
+ * \brief	Computes where the text of a frame or a button is drawn.
+ *
+ * @param	text		The text.
+ * @param	font		Its font.
+ * @param	anchor		Where it is placed in the content.
+ * @param	content		The content_rect of the widget.
+ * @return	The rectangle covered by the text (not clipped by the content).
+*/
+ei_rect_t ei_text_rect(const char* text, ei_font_t font, ei_anchor_t anchor, ei_rect_t content);
+
+
 /**
  * \brief	A function that draws widgets of a class frame or button.
  *
@@ -69,6 +81,7 @@ ei_linked_point_t* ei_rounded_frame_all(ei_rect_t rect, int r);
  * @param	surface		Where to draw the widget. The actual location of the widget in the
  *				surface is stored in its "screen_location" field.
  * @param	pick_surface	The surface used for picking (i.e. find the widget below the mouse pointer).
+ *				NULL unless the application uses \ref ei_picking_offscreen.
  * @param	clipper		If not NULL, the drawing is restricted within this rectangle
  *				(expressed in the surface reference frame).
  * @param	isFrame		If true, this function draws a frame (that does not have a corner-radius).
@@ -80,6 +93,17 @@ void drawframebuttonclasses(struct ei_widget_t*     widget,
                       ei_rect_t*        clipper,
                       ei_bool_t         isFrame);
 
+/**
+ * \brief Computes the colors of the borders of a frame or button.
+ *
+ * @param   color	The color of the widget.
+ * @param   relief	The relief of the widget.
+ * @param   top_color	Where to store the color of the top and left borders.
+ * @param   bottom_color	Where to store the color of the bottom and right borders.
+*/
+void ei_relief_colors(ei_color_t color, ei_relief_t relief, ei_color_t* top_color, ei_color_t* bottom_color);
+
+
 /**
  * \brief Returns a darker color than the one in parameter.
  *
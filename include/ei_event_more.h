@@ -30,9 +30,17 @@ ei_linked_binded_event *get_top_event_bind();
 
 
 /**
- * \brief Destroys the events binded to the button.
- * @param The widget to "isolate".
+ * \brief Disables, in one pass, the events binded to a widget and to its descendants (which are
+ *        being destroyed). They are freed by \ref ei_event_sweep.
+ * @param The root of the subtree to "isolate".
 */
-void destroy_event_binded_to_widget(ei_widget_t *widget);
+void destroy_event_binded_to_subtree(ei_widget_t *root);
+
+
+/**
+ * \brief Frees the disabled binded events. Called by the event loop, once the callbacks of an
+ *        event have been run.
+*/
+void ei_event_sweep(void);
 
 #endif
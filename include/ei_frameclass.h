@@ -9,6 +9,8 @@
 
 #include "ei_widget.h"
 #include "ei_widgetclass.h"
+#include "ei_surface.h"
+#include "ei_scale.h"
 
 
 /**
@@ -16,28 +18,38 @@
  */
 typedef char 		ei_widget_text_t[40];
 
+/**
+ * \brief	The optional attributes of the frames and buttons: the bit of an attribute is set in
+ *		the presence mask of the widget when the attribute is set.
+ */
+typedef enum {
+    ei_attr_text        = 1 << 0,   ///< The widget has a text.
+    ei_attr_img         = 1 << 1,   ///< The widget has an image.
+    ei_attr_img_scaling = 1 << 2    ///< The image is scaled (it has its natural size otherwise).
+} ei_attr_t;
+
 /**
  * \brief	The frame widget class
- *      attributes are pointers (excpet 'widget' for polymorphism): 
- *      we can know if an attribute has been 
- *      initialised before by testing if it is NULL
+ *      attributes are stored in the frame itself (a single allocation by frame):
+ *      the optional ones are valid only if their bit is set in 'set'
  */
 typedef struct ei_frame_t {
     ei_widget_t widget;     ///< The widget seen as a frame, for polymorphism.
-    int*	border_width;   ///< Border width of the frame.
-    ei_relief_t* relief;    ///< Relief of the frame.
-    ei_color_t* color;      ///< Color of the frame.
+    unsigned	set;        ///< Presence mask of the optional attributes, see \ref ei_attr_t.
+    int	border_width;       ///< Border width of the frame.
+    ei_relief_t relief;     ///< Relief of the frame.
+    ei_color_t color;       ///< Color of the frame.
 
     /* for frames having text */
-    ei_widget_text_t* text; ///< Text, array of 40 characters at most.
-    ei_font_t* text_font;   ///< Text font.
-    ei_color_t* text_color; ///< Text color.
-    ei_anchor_t* text_anchor;   ///< Anchor, to know where to put the text.
+    ei_widget_text_t text;  ///< Text, array of 40 characters at most (if ei_attr_text is set).
+    ei_font_t text_font;    ///< Text font.
+    ei_color_t text_color;  ///< Text color.
+    ei_anchor_t text_anchor;    ///< Anchor, to know where to put the text.
 
     /* if frame does not have text, it has an image */
-    ei_surface_t* img;      ///< The image.
-    ei_rect_t* img_rect;   ///< A subrectangle of the image we want to handle.
-    ei_anchor_t* img_anchor;    ///< Anchor, to know where to put the image.
+    ei_surface_view_t img;  ///< The image: a view on the subrectangle of the (shared) surface we want to handle (if ei_attr_img is set).
+    ei_anchor_t img_anchor;     ///< Anchor, to know where to put the image.
+    ei_image_scaling_t img_scaling;     ///< How the image is fitted (if ei_attr_img_scaling is set, natural size otherwise).
 } ei_frame_t;
 
 
@@ -67,6 +79,7 @@ void		releaseframe	(struct ei_widget_t*	widget);
  * @param	surface		Where to draw the widget. The actual location of the widget in the
  *				surface is stored in its "screen_location" field.
  * @param	pick_surface	The surface used for picking (i.e. find the widget below the mouse pointer).
+ *				NULL unless the application uses \ref ei_picking_offscreen.
  * @param	clipper		If not NULL, the drawing is restricted within this rectangle
  *				(expressed in the surface reference frame).
  */
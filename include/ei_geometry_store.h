@@ -0,0 +1,104 @@
+/**
+ *  @file	ei_geometry_store.h
+ *  @brief	Copy of the geometry of the widgets in parallel arrays (their rectangles and the
+ *		hierarchy), indexed by the pick ids of the widgets: the traversals that only
+ *		need the geometry (culling, hit testing) stream over contiguous memory instead of
+ *		following the pointers of the widgets.
+ *
+ */
+
+#ifndef EI_GEOMETRY_STORE_H
+#define EI_GEOMETRY_STORE_H
+
+#include "ei_types.h"
+#include "ei_widget.h"
+
+
+/* no widget (parent of the root, end of a list of children, free slot) */
+#define EI_GEOMETRY_NONE	(-1)
+
+
+/**
+ * \brief	Flags of a widget in the store.
+ */
+typedef enum {
+	ei_geometry_mapped	= 1 << 0,	///< The widget is managed by a geometry manager.
+	ei_geometry_unclipped	= 1 << 1,	///< The widget is clipped by the content of its grandparent
+						///< instead of its parent (close buttons of the toplevels).
+	ei_geometry_hidden	= 1 << 2	///< The widget and its descendants are not drawn nor picked.
+} ei_geometry_flag_t;
+
+
+/**
+ * \brief	The arrays of the store. The slot of a widget is its pick_id.
+ */
+typedef struct ei_geometry_store_t {
+	uint32_t	size;		///< Number of slots of the arrays.
+	ei_rect_t*	screen;		///< The screen_location of the widgets.
+	ei_rect_t*	content;	///< The rectangle their content_rect points to.
+	ei_rect_t*	bounds;		///< What they cover: their screen_location, or the draw_rect of the toplevels.
+	int32_t*	parent;		///< The slot of their parent.
+	int32_t*	first_child;	///< The slot of their first child.
+	int32_t*	last_child;	///< The slot of their last child.
+	int32_t*	next_sibling;	///< The slot of their next sibling.
+	uint8_t*	flags;		///< Their \ref ei_geometry_flag_t.
+} ei_geometry_store_t;
+
+
+/**
+ * \brief	Returns the store, for reading. Its arrays are reallocated when a widget is added.
+ */
+const ei_geometry_store_t*	ei_geometry_store	(void);
+
+
+/**
+ * \brief	Adds a new widget (its pick_id is set) to the store, without parent nor children.
+ *		Called by \ref ei_widget_create.
+ *
+ * @param	widget		The new widget.
+ */
+void	ei_geometry_store_add		(ei_widget_t* widget);
+
+
+/**
+ * \brief	Mirrors the insertion of a widget in the list of the children of its parent.
+ *
+ * @param	widget		The widget, already inserted.
+ * @param	previous	The sibling it was inserted after, NULL if it is the first child.
+ */
+void	ei_geometry_store_link		(ei_widget_t* widget, ei_widget_t* previous);
+
+
+/**
+ * \brief	Mirrors the removal of a widget from the list of the children of its parent.
+ *
+ * @param	widget		The widget, already removed.
+ * @param	previous	The sibling it followed, NULL if it was the first child.
+ */
+void	ei_geometry_store_unlink	(ei_widget_t* widget, ei_widget_t* previous);
+
+
+/**
+ * \brief	Copies the rectangles of a widget, and whether it is mapped, to the store. Called
+ *		after its geometry manager computed its geometry, and when it is unmapped.
+ *
+ * @param	widget		The widget.
+ */
+void	ei_geometry_store_update	(ei_widget_t* widget);
+
+
+/**
+ * \brief	Frees the slot of a destroyed widget (it is reused with its pick_id).
+ *
+ * @param	widget		The widget being destroyed.
+ */
+void	ei_geometry_store_remove	(ei_widget_t* widget);
+
+
+/**
+ * \brief	Frees the arrays. Called by \ref ei_app_free.
+ */
+void	ei_geometry_store_free		(void);
+
+
+#endif
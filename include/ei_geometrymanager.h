@@ -102,6 +102,42 @@ ei_geometrymanager_t*	ei_geometrymanager_from_name	(ei_geometrymanager_name_t na
 void			ei_geometrymanager_unmap	(ei_widget_t*		widget);
 
 
+/**
+ * \brief	Same as \ref ei_geometrymanager_unmap, without invalidating the screen_location of
+ *		the widget: used when a whole subtree is destroyed, whose area is invalidated once.
+ *
+ * @param	widget		The widget to forget.
+ */
+void			ei_geometrymanager_release	(ei_widget_t*		widget);
+
+
+
+/**
+ * \brief	Updates the geometry of a widget whose ancestors moved. The geometry managers
+ *		record the position of a widget relative to the content_rect of its parent:
+ *		when only the position of the parent changed since, the rectangles of the widget
+ *		(its screen_location, its content_rect) are moved by the same offset, without
+ *		running its geometry manager. Called before a widget is drawn or picked, the
+ *		ancestors first.
+ *
+ * @param	widget		The widget.
+ */
+void			ei_geometrymanager_resolve	(ei_widget_t*		widget);
+
+
+
+/**
+ * \brief	Places the children of a widget after its geometry changed. Called by the
+ *		geomnotifyfunc of the classes of the library, once the content_rect is computed.
+ *		When the size of the content_rect did not change, the children keep their
+ *		place relative to it: they are only marked as moved, and are updated by
+ *		\ref ei_geometrymanager_resolve when they are drawn or picked.
+ *
+ * @param	widget		The widget whose geometry changed.
+ */
+void			ei_geometrymanager_run_children	(ei_widget_t*		widget);
+
+
 
 /**
  * \brief	Registers the "placer" geometry manager in the program. This must be called only
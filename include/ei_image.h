@@ -0,0 +1,99 @@
+/**
+ *  @file	ei_image.h
+ *  @brief	Cache of the decoded images, keyed by file name. The images are converted to the
+ *		channel order of the root surface, and their transparent pixels are recorded.
+ *		Images can be decoded by a worker thread, without blocking the event loop, and
+ *		are kept decoded on disk between runs (see ei_image_disk.h).
+ *
+ */
+
+#ifndef EI_IMAGE_H
+#define EI_IMAGE_H
+
+#include "ei_types.h"
+#include "ei_widget.h"
+#include "ei_event.h"
+#include "hw_interface.h"
+
+
+/**
+ * \brief	Loads an image, or returns it from the cache if the file was already loaded. At
+ *		the first load, the image is converted to the channel order of the root surface (so
+ *		that it is copied without swizzling), and its opacity is recorded (see
+ *		\ref ei_surface_set_opacity). If a disk cache is set (see
+ *		\ref ei_image_disk_set_directory), the converted image is read from it instead
+ *		of being decoded, or stored in it. The image is shared: it must not be drawn on.
+ *		Must be called after \ref ei_app_create.
+ *
+ * @param	filename	The name of the image file.
+ * @return	The image, with a reference for the caller (to drop with
+ *		\ref ei_surface_release). NULL if the file could not be loaded.
+ */
+ei_surface_t	ei_image_load		(const char* filename);
+
+
+/**
+ * \brief	Loads the image of a frame or a button in the background: the file is decoded by a
+ *		worker thread, and the widget shows a placeholder until then. When the image is
+ *		decoded, an event is posted with \ref hw_event_post_app, and the event loop
+ *		configures the image of the widget (with img_rect), which only invalidates the
+ *		rectangle of the widget. The requested size of the widget is kept: it must be set
+ *		by the application, since the size of the image is not known yet.
+ *		If the image is already in the cache, it is configured at once.
+ *
+ * @param	filename	The name of the image file.
+ * @param	widget		A frame or a button.
+ * @param	img_rect	If not NULL, the subpart of the image to use (see \ref ei_frame_configure).
+ * @param	placeholder	The image shown until the image is loaded, or NULL to keep the
+ *				current content of the widget.
+ * @return	EI_FALSE if the widget is neither a frame nor a button.
+ */
+ei_bool_t	ei_image_load_async	(const char* filename, ei_widget_t* widget, const ei_rect_t* img_rect,
+					 ei_surface_t placeholder);
+
+
+/**
+ * \brief	Handles the event posted when an image is decoded by \ref ei_image_load_async.
+ *		Called by \ref ei_app_run for the events of type \ref ei_ev_app.
+ *
+ * @param	event		The event.
+ * @return	EI_TRUE if the event was posted by \ref ei_image_load_async (and is handled).
+ */
+ei_bool_t	ei_image_handle_event	(const ei_event_t* event);
+
+
+/**
+ * \brief	Cancels the background loads of a widget. Called when the widget is destroyed.
+ *
+ * @param	widget		The widget.
+ */
+void		ei_image_forget_widget	(ei_widget_t* widget);
+
+
+/**
+ * \brief	Converts an image to the channel order of the surfaces created for a surface (with
+ *		an alpha channel), which is the order of the cached images and of the tiles.
+ *
+ * @param	image		The image (must be unlocked). Freed if it is converted.
+ * @param	channels	The surface giving the channel order (the root surface).
+ * @return	The converted image, or image if it is already in this order.
+ */
+ei_surface_t	ei_image_convert	(ei_surface_t image, ei_surface_t channels);
+
+
+/**
+ * \brief	Computes and records the opacity of a surface (see \ref ei_surface_set_opacity).
+ *
+ * @param	surface		The surface (must be unlocked).
+ */
+void		ei_image_scan_opacity	(ei_surface_t surface);
+
+
+/**
+ * \brief	Stops the worker thread, and drops the references of the cache to the images.
+ *		Called by \ref ei_app_free.
+ */
+void		ei_image_cache_free	(void);
+
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ *  @file	ei_image_disk.h
+ *  @brief	Persistent cache of the decoded images: the converted pixels of an image are
+ *		stored in a file of a cache directory, and mapped in memory at the next runs
+ *		instead of decoding the image again.
+ *
+ */
+
+#ifndef EI_IMAGE_DISK_H
+#define EI_IMAGE_DISK_H
+
+#include "ei_types.h"
+#include "hw_interface.h"
+
+
+/**
+ * \brief	Sets the directory of the cache files (it must exist). Must be called by the
+ *		main thread, before loading images. Defaults to the environment variable
+ *		EI_IMAGE_CACHE, the cache is disabled if it is not set.
+ *
+ * @param	directory	The directory, or NULL to disable the cache.
+ */
+void		ei_image_disk_set_directory	(const char* directory);
+
+
+/**
+ * \brief	Returns the directory of the cache files (see \ref ei_image_disk_set_directory).
+ *		The first call reads the environment: it is made by the main thread, by
+ *		\ref ei_image_load_async before starting the image worker thread, which then
+ *		only reads the directory.
+ *
+ * @return	The directory, or NULL if the cache is disabled.
+ */
+const char*	ei_image_disk_directory		(void);
+
+
+/**
+ * \brief	Loads an image from its cache file, if the file is in the cache for its current
+ *		modification time and size. Only calls the hardware layer, and only reads the
+ *		directory resolved before the image worker thread started: can be called by it.
+ *
+ * @param	filename	The name of the image file.
+ * @param	channels	The surface giving the channel order (the root surface).
+ * @param	opaque		Where to store the opacity of the image (see \ref ei_surface_set_opacity).
+ * @param	visible		Where to store the bounding box of the non transparent pixels.
+ * @return	The image, or NULL if it is not in the cache.
+ */
+ei_surface_t	ei_image_disk_load		(const char* filename, ei_surface_t channels,
+						 ei_bool_t* opaque, ei_rect_t* visible);
+
+
+/**
+ * \brief	Stores a decoded image in the cache.
+ *
+ * @param	filename	The name of the image file.
+ * @param	image		The image, converted to the channel order of the root surface (must
+ *				be unlocked).
+ * @param	opaque		The opacity of the image.
+ * @param	visible		The bounding box of the non transparent pixels.
+ */
+void		ei_image_disk_store		(const char* filename, ei_surface_t image,
+						 ei_bool_t opaque, const ei_rect_t* visible);
+
+
+#endif
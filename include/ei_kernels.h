@@ -0,0 +1,118 @@
+/**
+ *  @file	ei_kernels.h
+ *  @brief	Pixel kernels used by the drawing functions (fill, copy, blend, scale...), with scalar,
+ *		SSE2 and AVX2 variants selected at run time.
+ *
+ */
+
+#ifndef EI_KERNELS_H
+#define EI_KERNELS_H
+
+#include <stdint.h>
+#include "ei_types.h"
+#include "ei_surface.h"
+
+
+/* the SSE2 and AVX2 variants are compiled for x86 processors, with gcc or clang */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define EI_KERNELS_X86 1
+#endif
+
+
+/* channel of index i of a pixel (i is a constant in the specialized kernels) */
+#define EI_CHANNEL(pixel, i)	(((pixel) >> (8 * (i))) & 0xff)
+/* alpha channel of a pixel, opaque if the format has no alpha channel */
+#define EI_ALPHA(pixel, ia)	((ia) < 0 ? 0xff : EI_CHANNEL(pixel, ia))
+/* builds a pixel from its channels (no alpha if ia is -1) */
+#define EI_PACK(r, g, b, a, ir, ig, ib, ia) \
+	(((uint32_t)(r) << (8 * (ir))) | ((uint32_t)(g) << (8 * (ig))) | ((uint32_t)(b) << (8 * (ib))) | \
+	 ((ia) < 0 ? 0 : (uint32_t)(a) << (8 * ((ia) & 3))))
+/* x / 255, rounded (exact for 0 <= x <= 255 * 255) */
+#define EI_DIV255(x)		((((x) + 128) + (((x) + 128) >> 8)) >> 8)
+
+
+/**
+ * \brief	A set of pixel kernels. All of them work on blocks of width x height pixels, the
+ *		pitches are the distances between two rows, in pixels (in bytes for the masks).
+ */
+typedef struct ei_kernels_t {
+	const char*	name;		///< "scalar", "sse2" or "avx2".
+
+	/** \brief Fills the block with a pixel value. */
+	void		(*fill)		(uint32_t* dst, int dst_pitch, int width, int height, uint32_t value);
+
+	/** \brief Copies the block between two surfaces of the same format. */
+	void		(*copy)		(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+					 int width, int height);
+
+	/** \brief Copies the block, converting the channel order from sf to df. */
+	void		(*swizzle)	(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+					 int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf);
+
+	/** \brief Blends the source over the destination, weighted by the alpha of the source. The
+	 *	   result is opaque. */
+	void		(*blend)	(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+					 int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf);
+
+	/** \brief Blends a color over the destination, weighted by an 8 bits coverage mask. The
+	 *	   mask values are mask_step bytes apart (1 for a plain mask, 4 to read the alpha
+	 *	   channel of a surface). The result is opaque. */
+	void		(*mask_tint)	(uint32_t* dst, int dst_pitch, const uint8_t* mask, int mask_step, int mask_pitch,
+					 int width, int height, const ei_pixel_format_t* df, ei_color_t color);
+
+	/** \brief Blends the source "over" a premultiplied (or opaque) destination, with one
+	 *	   multiply-add per channel. The source is premultiplied if src_premultiplied, else
+	 *	   it is premultiplied on the fly. The alpha channels are composed. */
+	void		(*blend_premul)	(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+					 int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf,
+					 ei_bool_t src_premultiplied);
+
+	/** \brief Same as mask_tint, for a premultiplied (or opaque) destination: the coverage is
+	 *	   multiplied by the alpha of the color, and the alpha channels are composed. */
+	void		(*mask_tint_premul)(uint32_t* dst, int dst_pitch, const uint8_t* mask, int mask_step, int mask_pitch,
+					 int width, int height, const ei_pixel_format_t* df, ei_color_t color);
+
+	/** \brief Scales the source, nearest neighbour: the pixel (x, y) of the block is the pixel
+	 *	   (xs[x], ys[y]) of the source. The pixels are copied as is. */
+	void		(*scale_nearest)(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+					 int width, int height, const int* xs, const int* ys);
+
+	/** \brief Scales the source, bilinear: the pixel (x, y) of the block mixes the columns
+	 *	   xs0[x] and xs1[x] of the source with the weights 256 - xw[x] and xw[x], then the
+	 *	   rows ys0[y] and ys1[y] with the weights 256 - yw[y] and yw[y]. The 4 channels
+	 *	   are mixed the same way, rounded after each step. */
+	void		(*scale_bilinear)(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+					 int width, int height, const int* xs0, const int* xs1, const uint8_t* xw,
+					 const int* ys0, const int* ys1, const uint8_t* yw);
+} ei_kernels_t;
+
+
+/**
+ * \brief	Selects the best kernels for the processor (cpuid). Called by \ref ei_app_create.
+ *		The environment variable EI_KERNELS ("scalar", "sse2" or "avx2") forces a variant,
+ *		for benchmarking and validation. A variant the processor does not support is
+ *		replaced by the best supported one.
+ */
+void ei_kernels_init(void);
+
+
+/**
+ * \brief	Returns the selected kernels (initializes them if \ref ei_kernels_init was not
+ *		called yet).
+ *
+ * @return	The kernel table.
+ */
+const ei_kernels_t* ei_kernels(void);
+
+
+/**
+ * \brief	The kernel variants (the SIMD ones only exist if EI_KERNELS_X86 is defined).
+ */
+extern const ei_kernels_t ei_kernels_scalar;
+#ifdef EI_KERNELS_X86
+extern const ei_kernels_t ei_kernels_sse2;
+extern const ei_kernels_t ei_kernels_avx2;
+#endif
+
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ *  @file	ei_picking.h
+ *  @brief	Finds the widget under a point of the root window, either by reading an offscreen
+ *		pick surface, a compact buffer of 16 bits ids, or geometrically by hit-testing the
+ *		shapes of the widgets.
+ *
+ */
+
+#ifndef EI_PICKING_H
+#define EI_PICKING_H
+
+#include "ei_types.h"
+#include "ei_widget.h"
+#include "ei_application.h"
+
+
+/**
+ * \brief	Initializes the picking engine. Called once by \ref ei_app_create.
+ *
+ * @param	root_surface	The surface of the root window (used for the channel indices of
+ *				the pick surface).
+ * @param	size		The size of the root window.
+ * @param	mode		The picking mode selected with \ref ei_app_set_picking_mode.
+ */
+void ei_picking_init(ei_surface_t root_surface, ei_size_t size, ei_picking_mode_t mode);
+
+
+/**
+ * \brief	Releases the pick surface and the spatial index. Called by \ref ei_app_free.
+ */
+void ei_picking_free(void);
+
+
+/**
+ * \brief	Gives a pick id to a new widget. The ids of the destroyed widgets are reused, so
+ *		that they stay below the number of living widgets. Called by \ref ei_widget_create.
+ *
+ * @param	widget	The new widget.
+ * @return	Its pick id.
+ */
+uint32_t ei_picking_register(ei_widget_t* widget);
+
+
+/**
+ * \brief	Releases the pick id of a widget. Called when the widget is destroyed.
+ *
+ * @param	widget	The widget being destroyed.
+ */
+void ei_picking_unregister(ei_widget_t* widget);
+
+
+/**
+ * \brief	Returns the widget of a pick id.
+ *
+ * @param	id	The pick id.
+ * @return	The living widget having this id, NULL if the id is free.
+ */
+ei_widget_t* ei_picking_widget(uint32_t id);
+
+
+/**
+ * \brief	Returns the surface the draw functions must fill with the pick colors.
+ *
+ * @return	The pick surface, or NULL if the current mode does not use one.
+ */
+ei_surface_t ei_picking_surface(void);
+
+
+/**
+ * \brief	Tells the picking engine that the geometry of some widgets has changed. The
+ *		spatial index of the geometric mode is rebuilt on the next pick.
+ */
+void ei_picking_invalidate(void);
+
+
+/**
+ * \brief	Updates the compact pick buffer (\ref ei_picking_compact and
+ *		\ref ei_picking_compact_half modes) from the shapes of the widgets. Does nothing in
+ *		the other modes, where the pick surface is filled by the draw functions.
+ *
+ * @param	rects	The rectangles that have been redrawn, or NULL for the whole root window.
+ */
+void ei_picking_update(const ei_linked_rect_t* rects);
+
+
+/**
+ * \brief	Returns the top-most widget at a location of the root window.
+ *
+ * @param	where	The location, in the root window coordinates.
+ * @return	The widget, the root widget if no other widget is there, or NULL if the location
+ *		is outside of the root window.
+ */
+ei_widget_t* ei_picking_find(ei_point_t where);
+
+
+/**
+ * \brief	Tells if a widget is the top-most widget at a location of the root window.
+ *
+ * @param	widget	The widget to test.
+ * @param	where	The location, in the root window coordinates.
+ * @return	EI_TRUE if the widget is the one that would be picked at this location.
+ */
+ei_bool_t ei_picking_is_under(ei_widget_t* widget, ei_point_t where);
+
+
+/**
+ * \brief	Exact shape test of a widget: rounded corners of the buttons, decorations of the
+ *		toplevels. Does not take clipping by the ancestors into account.
+ *
+ * @param	widget	The widget to test.
+ * @param	where	The location, in the root window coordinates.
+ * @return	EI_TRUE if the location is inside the shape of the widget.
+ */
+ei_bool_t ei_picking_hit_shape(ei_widget_t* widget, ei_point_t where);
+
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ *  @file	ei_pool.h
+ *  @brief	Pool of reusable pixel buffers, for the temporary buffers of the library. The
+ *		buffers are bucketed by size (powers of 2), and the free ones are kept up to a
+ *		byte cap.
+ *
+ */
+
+#ifndef EI_POOL_H
+#define EI_POOL_H
+
+#include <stddef.h>
+
+
+/* default maximum of bytes kept by the pool in its free buffers */
+#define EI_POOL_DEFAULT_CAP	(8 << 20)
+
+
+/**
+ * \brief	Statistics of the pool.
+ */
+typedef struct ei_pool_stats_t {
+	unsigned long	hits;		///< Number of buffers reused from the pool.
+	unsigned long	misses;		///< Number of buffers allocated because the pool had none of the size.
+	size_t		bytes_retained;	///< Bytes of the free buffers kept by the pool.
+	size_t		bytes_cap;	///< Maximum of bytes_retained.
+} ei_pool_stats_t;
+
+
+/**
+ * \brief	Gets a buffer of width x height pixels from the pool (or allocates it). Its rows
+ *		start on \ref EI_ROW_ALIGN bytes, like the ones of \ref ei_surface_alloc_rows.
+ *
+ * @param	width		The width, in pixels.
+ * @param	height		The height, in pixels.
+ * @param	pixel_size	The size of a pixel, in bytes (a divisor of \ref EI_ROW_ALIGN).
+ * @param	pitch		Where to store the distance between two rows, in pixels.
+ * @return	The buffer (uninitialized), to give back with \ref ei_pool_put, or NULL if it could
+ *		not be allocated.
+ */
+void*		ei_pool_get		(int width, int height, int pixel_size, int* pitch);
+
+
+/**
+ * \brief	Gives a buffer back to the pool. It is freed if keeping it would exceed the cap.
+ *
+ * @param	buffer		A buffer returned by \ref ei_pool_get, or NULL.
+ */
+void		ei_pool_put		(void* buffer);
+
+
+/**
+ * \brief	Sets the maximum of bytes kept by the pool in its free buffers (defaults to
+ *		\ref EI_POOL_DEFAULT_CAP), and frees the free buffers over it.
+ *
+ * @param	bytes		The cap, 0 to disable the pool.
+ */
+void		ei_pool_set_cap		(size_t bytes);
+
+
+/**
+ * \brief	Returns the statistics of the pool.
+ *
+ * @return	The statistics.
+ */
+ei_pool_stats_t	ei_pool_get_stats	(void);
+
+
+/**
+ * \brief	Frees the free buffers of the pool. Called by \ref ei_app_free.
+ */
+void		ei_pool_free		(void);
+
+
+#endif
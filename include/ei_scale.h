@@ -0,0 +1,114 @@
+/**
+ *  @file	ei_scale.h
+ *  @brief	Scaling of images (nearest neighbour or bilinear), stretched or in nine slices, and
+ *		cache of the scaled images of the widgets, kept for each target size.
+ *
+ */
+
+#ifndef EI_SCALE_H
+#define EI_SCALE_H
+
+#include <stddef.h>
+#include "ei_types.h"
+#include "ei_surface.h"
+
+
+/* maximum number of scaled images kept in the cache */
+#define EI_SCALE_CACHE_ENTRIES	64
+/* default maximum of bytes of the scaled images kept in the cache */
+#define EI_SCALE_CACHE_DEFAULT_CAP	(16 << 20)
+
+
+/**
+ * \brief	The filters used to scale an image.
+ */
+typedef enum {
+	ei_filter_nearest	= 0,	///< Nearest neighbour: the pixels are repeated or skipped.
+	ei_filter_bilinear		///< Bilinear: the 4 nearest pixels are mixed.
+} ei_filter_t;
+
+
+/**
+ * \brief	How an image is fitted in the content of a frame or of a button.
+ */
+typedef enum {
+	ei_image_natural	= 0,	///< Not scaled, placed with the anchor of the image (the default).
+	ei_image_stretch,		///< Scaled to the size of the content.
+	ei_image_nine_slice		///< Cut in 9 slices by the 4 insets: the corners are not scaled, the
+					///< edges are scaled along the edge, the center is stretched.
+} ei_image_mode_t;
+
+
+/**
+ * \brief	The scaling of the image of a frame or of a button.
+ */
+typedef struct ei_image_scaling_t {
+	ei_image_mode_t	mode;		///< How the image is fitted.
+	ei_filter_t	filter;		///< How the image is scaled.
+	int		slices[4];	///< For \ref ei_image_nine_slice, the insets of the slices in the
+					///< image: left, top, right, bottom.
+} ei_image_scaling_t;
+
+
+/**
+ * \brief	Scales src_rect of a descriptor to dst_rect of another one. Only the part of dst_rect
+ *		inside the clipper is written. The pixels are not converted: both descriptors must
+ *		have the same channel order.
+ *
+ * @param	dst		The destination.
+ * @param	dst_rect	The rectangle the source is scaled to, relative to dst.
+ * @param	src		The source.
+ * @param	src_rect	The rectangle of the source to scale, relative to src.
+ * @param	filter		The filter.
+ * @param	clipper		If not NULL, the pixels written are restricted within this rectangle.
+ */
+void			ei_scale_desc		(const ei_surface_desc_t*	dst,
+						 const ei_rect_t*		dst_rect,
+						 const ei_surface_desc_t*	src,
+						 const ei_rect_t*		src_rect,
+						 ei_filter_t			filter,
+						 const ei_rect_t*		clipper);
+
+
+/**
+ * \brief	Returns a view scaled to a size, scaling it if it is not in the cache. The least
+ *		recently used images are evicted when the cache is full. The scaled images are in
+ *		the pixel format of the surface of the view.
+ *
+ * @param	view		The view (its surface must be locked, and must not be drawn on
+ *				afterwards).
+ * @param	size		The target size.
+ * @param	scaling		How to scale (\ref ei_image_stretch or \ref ei_image_nine_slice).
+ * @return	The scaled image, owned by the cache and valid until the next call. NULL if it could
+ *		not be allocated.
+ */
+const ei_surface_desc_t*	ei_scale_cache_get	(const ei_surface_view_t*	view,
+							 ei_size_t			size,
+							 const ei_image_scaling_t*	scaling);
+
+
+/**
+ * \brief	Sets the maximum of bytes of the scaled images kept in the cache (defaults to
+ *		\ref EI_SCALE_CACHE_DEFAULT_CAP), and evicts the images over it.
+ *
+ * @param	bytes		The cap.
+ */
+void			ei_scale_cache_set_cap	(size_t bytes);
+
+
+/**
+ * \brief	Removes the scaled images of a surface from the cache. Called by
+ *		\ref ei_surface_forget.
+ *
+ * @param	surface		The surface.
+ */
+void			ei_scale_cache_forget	(ei_surface_t surface);
+
+
+/**
+ * \brief	Frees the cache. Called by \ref ei_app_free.
+ */
+void			ei_scale_cache_free	(void);
+
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ *  @file	ei_slab.h
+ *  @brief	Slab allocators of the widgets: the widgets of a class are allocated in chunks of
+ *		memory holding several of them, and the chunks are released at once when the
+ *		toplevel owning them (or the application) is destroyed.
+ *
+ */
+
+#ifndef EI_SLAB_H
+#define EI_SLAB_H
+
+#include <stddef.h>
+#include "ei_widget.h"
+#include "ei_widgetclass.h"
+
+
+/* number of widgets of the first chunk of a slab: the next chunks are twice bigger, up to
+   EI_SLAB_MAX_CHUNK_WIDGETS widgets */
+#define EI_SLAB_MIN_CHUNK_WIDGETS	4
+#define EI_SLAB_MAX_CHUNK_WIDGETS	1024
+
+
+/**
+ * \brief	The slabs of the widgets of a subtree (one by class of widget): the descendants of
+ *		a toplevel are allocated in its arena, the other widgets in the one of the
+ *		application.
+ */
+typedef struct ei_slab_arena_t ei_slab_arena_t;
+
+
+/**
+ * \brief	Allocates the widgets of a class in slabs instead of with its allocfunc. The
+ *		classes of the library are registered by their register function; an external
+ *		class opts in by calling this function after \ref ei_widgetclass_register. The
+ *		releasefunc of the class is still called before a widget is destroyed.
+ *
+ * @param	wclass		The class, already registered.
+ * @param	widget_size	The size of a widget of the class (the block its allocfunc allocates).
+ */
+void			ei_slab_register	(ei_widgetclass_t* wclass, size_t widget_size);
+
+
+/**
+ * \brief	Creates an empty arena.
+ *
+ * @return	The arena, to release with \ref ei_slab_arena_free.
+ */
+ei_slab_arena_t*	ei_slab_arena_create	(void);
+
+
+/**
+ * \brief	Allocates a widget, with all bytes set to 0: in the slab of its class in the
+ *		arena if the class was registered with \ref ei_slab_register, with the allocfunc
+ *		of the class otherwise.
+ *
+ * @param	arena		The arena, NULL for the one of the application.
+ * @param	wclass		The class of the widget.
+ * @return	The widget, its "slab" field set.
+ */
+ei_widget_t*		ei_slab_alloc		(ei_slab_arena_t* arena, ei_widgetclass_t* wclass);
+
+
+/**
+ * \brief	Frees a widget allocated by \ref ei_slab_alloc: its block can be reused by the
+ *		next widget of the same class allocated in the same arena.
+ *
+ * @param	widget		The widget, already released by its class.
+ */
+void			ei_slab_free		(ei_widget_t* widget);
+
+
+/**
+ * \brief	Releases all the chunks of an arena at once. Its widgets must have been destroyed.
+ *
+ * @param	arena		The arena, or NULL.
+ */
+void			ei_slab_arena_free	(ei_slab_arena_t* arena);
+
+
+/**
+ * \brief	Releases the arena of the application and forgets the registered classes. Called
+ *		by \ref ei_app_free.
+ */
+void			ei_slab_free_all	(void);
+
+
+#endif
@@ -0,0 +1,236 @@
+/**
+ *  @file	ei_surface.h
+ *  @brief	Information kept by the library about the surfaces: pixel format (cached on first
+ *		use), premultiplied alpha, reference count, row stride, opacity. Views on a part of a
+ *		surface, and descriptors used by the drawing code to address the pixels.
+ *
+ */
+
+#ifndef EI_SURFACE_H
+#define EI_SURFACE_H
+
+#include <stdint.h>
+#include "ei_types.h"
+#include "hw_interface.h"
+
+
+/* alignment of the rows of the pixel buffers allocated by the library, in bytes */
+#define EI_ROW_ALIGN		64
+
+
+/**
+ * \brief	The channel orders having specialized drawing kernels. Named after the channel at
+ *		each byte index of a pixel (ie. the indices returned by
+ *		\ref hw_surface_get_channel_indices): "bgra" means ib = 0, ig = 1, ir = 2, ia = 3.
+ */
+typedef enum {
+	ei_pixel_order_rgba	= 0,
+	ei_pixel_order_bgra,
+	ei_pixel_order_argb,
+	ei_pixel_order_abgr,
+	ei_pixel_order_other			///< Any other order (or no alpha channel): generic kernels.
+} ei_pixel_order_t;
+
+
+/**
+ * \brief	Pixel format descriptor of a surface.
+ */
+typedef struct ei_pixel_format_t {
+	int			ir;		///< Index of the red channel.
+	int			ig;		///< Index of the green channel.
+	int			ib;		///< Index of the blue channel.
+	int			ia;		///< Index of the alpha channel, -1 if the surface has no alpha channel.
+	ei_pixel_order_t	order;		///< The channel order, to select a specialized kernel.
+	ei_bool_t		premultiplied;	///< EI_TRUE if the color channels are premultiplied by the alpha channel.
+} ei_pixel_format_t;
+
+
+/**
+ * \brief	Returns the pixel format of a surface. It is queried from the hardware layer on the
+ *		first call for this surface, then cached until \ref ei_surface_free (or
+ *		\ref ei_surface_forget) is called.
+ *
+ * @param	surface		The surface.
+ * @return	The pixel format descriptor, owned by the library.
+ */
+const ei_pixel_format_t* ei_surface_format(ei_surface_t surface);
+
+
+/**
+ * \brief	Tells the library that the pixels of a surface have their color channels
+ *		premultiplied by their alpha (or not, the default). Blending onto such a surface
+ *		composes the alpha channels (layers), colors are mapped premultiplied by
+ *		\ref ei_map_rgba, and the surfaces drawn on it may be premultiplied or not.
+ *		Opaque surfaces (like the root window) are valid premultiplied surfaces: setting
+ *		the flag on the root surface switches all the drawing to the premultiplied pipeline.
+ *
+ * @param	surface		The surface.
+ * @param	premultiplied	EI_TRUE if its pixels are premultiplied.
+ */
+void ei_surface_set_premultiplied(ei_surface_t surface, ei_bool_t premultiplied);
+
+
+/**
+ * \brief	Converts the pixels of a surface with straight alpha (for example, an image returned
+ *		by \ref hw_image_load) to premultiplied alpha, and sets its flag (see
+ *		\ref ei_surface_set_premultiplied). Does nothing if the surface is already
+ *		premultiplied, or has no alpha channel.
+ *
+ * @param	surface		The surface (must be unlocked, it is locked during the conversion).
+ */
+void ei_surface_premultiply(ei_surface_t surface);
+
+
+/**
+ * \brief	Records which pixels of a surface are transparent, so that \ref ei_copy_surface
+ *		copies an opaque surface without blending, and skips the transparent borders of
+ *		the others. Computed by \ref ei_image_load for the images. The surface must not be
+ *		drawn on afterwards (or this must be called again).
+ *
+ * @param	surface		The surface.
+ * @param	opaque		EI_TRUE if all the pixels are opaque.
+ * @param	visible		The bounding box of the pixels which are not fully transparent
+ *				(an empty rectangle if the surface is fully transparent).
+ */
+void ei_surface_set_opacity(ei_surface_t surface, ei_bool_t opaque, const ei_rect_t* visible);
+
+
+/**
+ * \brief	Returns what is known about the transparent pixels of a surface (see
+ *		\ref ei_surface_set_opacity).
+ *
+ * @param	surface		The surface.
+ * @param	opaque		Where to store EI_TRUE if all the pixels are opaque.
+ * @param	visible		Where to store the bounding box of the pixels which are not fully
+ *				transparent.
+ * @return	EI_FALSE if nothing is known (opaque and visible are not set).
+ */
+ei_bool_t ei_surface_get_opacity(ei_surface_t surface, ei_bool_t* opaque, ei_rect_t* visible);
+
+
+/**
+ * \brief	Adds a reference to a surface, so that it is shared instead of copied. A surface
+ *		starts with one reference, owned by the code that created or loaded it.
+ *
+ * @param	surface		The surface.
+ */
+void ei_surface_retain(ei_surface_t surface);
+
+
+/**
+ * \brief	Drops a reference to a surface. The surface is freed (see \ref ei_surface_free)
+ *		when its last reference is dropped.
+ *
+ * @param	surface		The surface (must be unlocked if this is its last reference).
+ */
+void ei_surface_release(ei_surface_t surface);
+
+
+/**
+ * \brief	A view on a rectangle of a surface: it references the pixels of the surface, which
+ *		are not copied.
+ */
+typedef struct ei_surface_view_t {
+	ei_surface_t	surface;	///< The surface seen through the view (one reference is held by the view).
+	ei_rect_t	rect;		///< The part of the surface seen (offset and size), within the surface.
+} ei_surface_view_t;
+
+
+/**
+ * \brief	Creates a view on a rectangle of a surface, and adds a reference to the surface.
+ *
+ * @param	surface		The surface.
+ * @param	rect		The rectangle of the surface to see, clipped to the surface. NULL for
+ *				the whole surface.
+ * @return	The view, to release with \ref ei_surface_view_release.
+ */
+ei_surface_view_t ei_surface_view(ei_surface_t surface, const ei_rect_t* rect);
+
+
+/**
+ * \brief	Releases a view: drops its reference to the surface.
+ *
+ * @param	view		The view.
+ */
+void ei_surface_view_release(ei_surface_view_t* view);
+
+
+/**
+ * \brief	Describes the pixels of a surface or of a view for the drawing code: the rows of
+ *		a descriptor may be longer than its width (padded rows, views on a part of a
+ *		surface), so a pixel is always addressed with the pitch (see \ref EI_PIXEL_AT).
+ */
+typedef struct ei_surface_desc_t {
+	uint32_t*			pixels;		///< Address of the top-left pixel.
+	int				pitch;		///< Distance between two rows, in pixels (the stride).
+	ei_size_t			size;		///< Size, in pixels.
+	const ei_pixel_format_t*	format;		///< Pixel format.
+} ei_surface_desc_t;
+
+
+/* address of the pixel (x, y) of a descriptor */
+#define EI_PIXEL_AT(desc, x, y)	((desc)->pixels + (y) * (desc)->pitch + (x))
+
+
+/**
+ * \brief	Returns the descriptor of a surface.
+ *
+ * @param	surface		The surface (the pixels may only be accessed while it is locked).
+ * @return	The descriptor.
+ */
+ei_surface_desc_t ei_surface_desc(ei_surface_t surface);
+
+
+/**
+ * \brief	Returns the descriptor of a view: its pixels are the ones of the surface, starting
+ *		at the top-left corner of the rect, with the pitch of the surface.
+ *
+ * @param	view		The view (the pixels may only be accessed while its surface is locked).
+ * @return	The descriptor.
+ */
+ei_surface_desc_t ei_surface_view_desc(const ei_surface_view_t* view);
+
+
+/**
+ * \brief	Tells the library the distance between two rows of a surface, if it is not its
+ *		width (for example, a surface from another library with padded rows).
+ *
+ * @param	surface		The surface.
+ * @param	pitch		The distance between two rows, in pixels.
+ */
+void ei_surface_set_pitch(ei_surface_t surface, int pitch);
+
+
+/**
+ * \brief	Allocates a pixel buffer of width x height pixels, with each row starting on
+ *		\ref EI_ROW_ALIGN bytes, so that the vector kernels work on aligned blocks.
+ *
+ * @param	width		The width, in pixels.
+ * @param	height		The height, in pixels.
+ * @param	pixel_size	The size of a pixel, in bytes (a divisor of \ref EI_ROW_ALIGN).
+ * @param	pitch		Where to store the distance between two rows, in pixels.
+ * @return	The buffer (uninitialized), to free with free, or NULL if it could not be allocated.
+ */
+void* ei_surface_alloc_rows(int width, int height, int pixel_size, int* pitch);
+
+
+/**
+ * \brief	Removes everything the library knows about a surface. Must be called before
+ *		freeing a surface with \ref hw_surface_free directly, since a new surface may then
+ *		be allocated at the same address.
+ *
+ * @param	surface		The surface.
+ */
+void ei_surface_forget(ei_surface_t surface);
+
+
+/**
+ * \brief	Frees a surface and what the library knows about it. To use instead of
+ *		\ref hw_surface_free.
+ *
+ * @param	surface		The surface to free (must be unlocked).
+ */
+void ei_surface_free(ei_surface_t surface);
+
+
+#endif
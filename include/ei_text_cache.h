@@ -0,0 +1,56 @@
+/**
+ *  @file	ei_text_cache.h
+ *  @brief	Cache of the rendered texts: the coverage of the glyphs of a text, for a font, is
+ *		kept in a mask (from the buffer pool) and tinted with the color at each drawing.
+ *
+ */
+
+#ifndef EI_TEXT_CACHE_H
+#define EI_TEXT_CACHE_H
+
+#include <stdint.h>
+#include "ei_types.h"
+
+
+/* maximum number of texts kept in the cache */
+#define EI_TEXT_CACHE_ENTRIES	256
+
+
+/**
+ * \brief	The coverage mask of a rendered text.
+ */
+typedef struct ei_text_mask_t {
+	uint8_t*	coverage;	///< The coverage of each pixel (0 to 255).
+	int		pitch;		///< Distance between two rows, in bytes.
+	ei_size_t	size;		///< Size of the text, in pixels.
+} ei_text_mask_t;
+
+
+/**
+ * \brief	Returns the coverage mask of a text, rendering it if it is not in the cache. The
+ *		least recently used text is evicted when the cache is full.
+ *
+ * @param	text		The text.
+ * @param	font		The font.
+ * @return	The mask, owned by the cache and valid until the next call. NULL if the hardware
+ *		layer renders texts without alpha channel (the text must then be drawn as a surface).
+ */
+const ei_text_mask_t*	ei_text_cache_get	(const char* text, ei_font_t font);
+
+
+/**
+ * \brief	Removes the texts of a font from the cache. Called by \ref ei_font_free before
+ *		freeing the font, since a new font may then be allocated at the same address.
+ *
+ * @param	font		The font.
+ */
+void			ei_text_cache_forget_font(ei_font_t font);
+
+
+/**
+ * \brief	Empties the cache. Called by \ref ei_app_free.
+ */
+void			ei_text_cache_free	(void);
+
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ *  @file	ei_tiles.h
+ *  @brief	Tile pyramids, to show images too big to be kept in memory: an image is stored in a
+ *		file as square tiles, at its full resolution and at resolutions halved down to a
+ *		single tile. The tiles are read from the file when they are drawn, and the recently
+ *		used ones are kept in a cache.
+ *
+ */
+
+#ifndef EI_TILES_H
+#define EI_TILES_H
+
+#include "ei_types.h"
+#include "ei_surface.h"
+#include "hw_interface.h"
+
+
+/* width and height of the tiles, in pixels */
+#define EI_TILE_SIZE		256
+/* maximum number of levels of a pyramid */
+#define EI_TILES_MAX_LEVELS	32
+/* number of tiles kept in the cache beyond the visible ones (see \ref ei_tiles_set_visible) */
+#define EI_TILE_CACHE_TILES	64
+
+
+/**
+ * \brief	A tile pyramid (opaque).
+ */
+typedef struct ei_tile_pyramid_t ei_tile_pyramid_t;
+
+
+/**
+ * \brief	Statistics of the tile cache.
+ */
+typedef struct ei_tiles_stats_t {
+	unsigned long	hits;		///< Number of tiles found in the cache.
+	unsigned long	misses;		///< Number of tiles read from the pyramid files.
+} ei_tiles_stats_t;
+
+
+/**
+ * \brief	Opens the tile pyramid of an image. The pyramid file is kept in the cache directory
+ *		of the images (see \ref ei_image_disk_set_directory) and reused while the image file
+ *		is not modified: the image is only decoded to build the pyramid. Without cache
+ *		directory, the pyramid is built in a temporary file.
+ *
+ * @param	filename	The name of the image file.
+ * @param	channels	The surface giving the channel order (the root surface).
+ * @return	The pyramid, to close with \ref ei_tiles_close, or NULL if the image could not be
+ *		loaded.
+ */
+ei_tile_pyramid_t*	ei_tiles_open		(const char* filename, ei_surface_t channels);
+
+
+/**
+ * \brief	Returns the number of levels of a pyramid. The level 0 is the image at its full
+ *		resolution, each next level is half the size of the previous one.
+ *
+ * @param	pyramid		The pyramid.
+ * @return	The number of levels.
+ */
+int			ei_tiles_levels		(const ei_tile_pyramid_t* pyramid);
+
+
+/**
+ * \brief	Returns the size of the image at a level of a pyramid.
+ *
+ * @param	pyramid		The pyramid.
+ * @param	level		The level.
+ * @return	The size, in pixels.
+ */
+ei_size_t		ei_tiles_level_size	(const ei_tile_pyramid_t* pyramid, int level);
+
+
+/**
+ * \brief	Records the number of tiles of a pyramid shown at once. The cache holds the visible
+ *		tiles of all the pyramids and EI_TILE_CACHE_TILES more, so that drawing a pyramid
+ *		does not evict the tiles it has just read.
+ *
+ * @param	pyramid		The pyramid.
+ * @param	tiles		The number of visible tiles.
+ */
+void			ei_tiles_set_visible	(ei_tile_pyramid_t* pyramid, int tiles);
+
+
+/**
+ * \brief	Returns a tile of a level, reading it from the pyramid file if it is not in the
+ *		cache. The least recently used tiles are evicted when the cache is full.
+ *
+ * @param	pyramid		The pyramid.
+ * @param	level		The level.
+ * @param	column		The column of the tile (the tile starts at column * EI_TILE_SIZE).
+ * @param	row		The row of the tile.
+ * @return	The pixels of the tile (smaller than EI_TILE_SIZE on the right and bottom edges of
+ *		the level), owned by the cache and valid until the next call. NULL if the tile
+ *		does not exist or could not be read.
+ */
+const ei_surface_desc_t*	ei_tiles_get	(ei_tile_pyramid_t* pyramid, int level, int column, int row);
+
+
+/**
+ * \brief	Returns the statistics of the tile cache.
+ *
+ * @return	The statistics.
+ */
+ei_tiles_stats_t	ei_tiles_get_stats	(void);
+
+
+/**
+ * \brief	Closes a pyramid: removes its tiles from the cache, and closes its file.
+ *
+ * @param	pyramid		The pyramid.
+ */
+void			ei_tiles_close		(ei_tile_pyramid_t* pyramid);
+
+
+#endif
@@ -26,22 +26,24 @@ static int default_topbar_height = 30;
 
 /**
  * \brief	The toplevel widget class
- *      attributes are pointers (except 'widget' for polymorphism): 
- *      we can know if an attribute has been 
- *      initialised before by testing if it is NULL
+ *      attributes are stored in the toplevel itself (a single allocation by toplevel)
  */
 typedef struct ei_toplevel_t {
     ei_widget_t         widget;
-    ei_color_t*         background_color;
-    ei_rect_t*          draw_rect;
+    ei_color_t          background_color;
+    ei_rect_t           draw_rect;
                
-    char**              title;
-    ei_font_t*          title_font;
+    char*               title;
+    ei_font_t           title_font;
 
-    int*                border_width;
-    ei_bool_t*          closable;
-    ei_axis_set_t*      resizable;
-    ei_size_t*          min_size;
+    int                 border_width;
+    ei_bool_t           closable;
+    ei_axis_set_t       resizable;
+    ei_size_t           min_size;
+    ei_widget_t*        quit_button;    ///< The quit button, NULL if the toplevel is not closable.
+    ei_widget_t*        resize_button;  ///< The resize button, NULL if the toplevel is not resizable.
+
+    struct ei_slab_arena_t* arena;  ///< The slabs of the descendants, released at once with the toplevel.
 } ei_toplevel_t;
 
 
@@ -71,6 +73,7 @@ void		releasetoplevel	(struct ei_widget_t*	widget);
  * @param	surface		Where to draw the widget. The actual location of the widget in the
  *				surface is stored in its "screen_location" field.
  * @param	pick_surface	The surface used for picking (i.e. find the widget below the mouse pointer).
+ *				NULL unless the application uses \ref ei_picking_offscreen.
  * @param	clipper		If not NULL, the drawing is restricted within this rectangle
  *				(expressed in the surface reference button).
  */
@@ -94,6 +97,15 @@ void	setdefaultstoplevel(struct ei_widget_t*	widget);
  */
 void	geomnotifytoplevel	(struct ei_widget_t*	widget);
 
+/**
+ * \brief	Computes where a title is drawn in the title bar of a toplevel.
+ *
+ * @param	toplevel	The toplevel.
+ * @param	title		The title.
+ * @return	The rectangle covered by the title (not clipped by the toplevel).
+ */
+ei_rect_t	ei_toplevel_title_rect	(ei_toplevel_t* toplevel, const char* title);
+
 
 
 
@@ -147,6 +159,19 @@ ei_bool_t end_resize(ei_widget_t* w_resizebutton, ei_event_t* event, void* param
 ei_bool_t resize(ei_widget_t* w_resizebutton, ei_event_t* event, void* params);
 
 
+/**
+ * \brief the callback bound to any widget, raising the toplevels containing the clicked widget
+ * 		above their siblings (it does not consume the event)
+ * 
+ * @param widget : NULL (the callback is bound to the "all" tag)
+ * @param event : the button down event
+ * @param params : additionnal parameters the user can add
+ * 
+ * @return EI_FALSE, so that the clicked widget still handles the event
+ */
+ei_bool_t raise_toplevel(ei_widget_t* widget, ei_event_t* event, void* params);
+
+
 /**
  * \brief the callback to begin the move of a toplevel
  * 
@@ -149,7 +149,7 @@ typedef enum {
  * @brief	An opaque type for handling fonts.
  *
  *		Fonts are created by calling \ref hw_text_font_create and released by calling
- *		\ref hw_text_font_free.
+ *		\ref ei_font_free.
  */
 typedef void*		ei_font_t;
 
@@ -0,0 +1,126 @@
+/**
+ *  @file	ei_viewerclass.h
+ *  @brief	allocfunc, releasefunc, drawfunc, setdefaultsfunc, geomnotifyfunc of viewer class.
+ *
+ */
+
+#ifndef EI_VIEWERCLASS_H
+#define EI_VIEWERCLASS_H
+
+#include "ei_widget.h"
+#include "ei_widgetclass.h"
+#include "ei_event.h"
+#include "ei_tiles.h"
+
+
+/**
+ * \brief	The viewer widget class: shows an image from its tile pyramid (see \ref ei_tiles_open),
+ *		at the resolution of one level of the pyramid, and can be panned with the mouse.
+ *      attributes are stored in the viewer itself (a single allocation by viewer)
+ */
+typedef struct ei_viewer_t {
+    ei_widget_t         widget;     ///< The widget seen as a viewer, for polymorphism.
+    ei_color_t          color;      ///< Color of the background, around the image.
+    ei_tile_pyramid_t*  pyramid;    ///< The tiles of the image, NULL if there is no image.
+    int                 level;      ///< The level of the pyramid which is shown.
+    ei_point_t          offset;     ///< The pixel of the level shown at the top left corner of the content.
+} ei_viewer_t;
+
+
+/**
+ * \brief	A function that allocates a block of memory that is big enough to store the
+ *		attributes of a widget of a class viewer. After allocation, the function *must*
+ *		initialize the memory to 0.
+ *
+ * @return		A block of memory with all bytes set to 0.
+ */
+void*       allocviewer		(void);
+
+/**
+ * \brief	A function that releases the memory used by a viewer before it is destroyed.
+ *		The \ref ei_widget_t structure itself, passed as parameter, must *not* be freed by
+ *		these functions.
+ *
+ * @param	widget		The viewer which resources are to be freed.
+ */
+void		releaseviewer	(struct ei_widget_t*	widget);
+
+/**
+ * \brief	A function that draws widgets of a class: only the tiles in the clipper are drawn,
+ *		the ones which are not in the tile cache are read from the pyramid.
+ *
+ * @param	widget		A pointer to the widget instance to draw.
+ * @param	surface		Where to draw the widget. The actual location of the widget in the
+ *				surface is stored in its "screen_location" field.
+ * @param	pick_surface	The surface used for picking (i.e. find the widget below the mouse pointer).
+ *				NULL unless the application uses \ref ei_picking_offscreen.
+ * @param	clipper		If not NULL, the drawing is restricted within this rectangle
+ *				(expressed in the surface reference frame).
+ */
+void	drawviewer		(struct ei_widget_t*		widget,
+								ei_surface_t		surface,
+								ei_surface_t		pick_surface,
+								ei_rect_t*			clipper);
+
+/**
+ * \brief	A function that sets the default values for a class.
+ *
+ * @param	widget		A pointer to the widget instance to initialize.
+ */
+void	setdefaultsviewer(struct ei_widget_t*	widget);
+
+/**
+ * \brief 	A function that is called to notify the widget that its geometry has been modified
+ *		by its geometry manager.
+ *
+ * @param	widget		The widget instance to notify of a geometry change.
+ */
+void	geomnotifyviewer	(struct ei_widget_t*	widget);
+
+
+/**
+ * \brief Keeps the shown part of the image within the image (centers the image if it is
+ *	  smaller than the content of the viewer).
+ *
+ * @param viewer : the viewer.
+ */
+void ei_viewer_clamp_offset(ei_viewer_t* viewer);
+
+
+/**
+ * \brief the callback to begin panning a viewer
+ *
+ * @param w_viewer : set to NULL (the viewer is the one under the mouse)
+ * @param event : the event telling to begin panning
+ * @param params : additionnal parameters the user can add
+ *
+ * @return the boolean of the callback (true if the event occurs, false otherwise)
+ */
+ei_bool_t beg_pan(ei_widget_t* w_viewer, ei_event_t* event, void* params);
+
+
+/**
+ * \brief the callback to pan a viewer
+ *
+ * @param w_viewer : set to NULL
+ * @param event : the event telling to pan
+ * @param params : additionnal parameters the user can add
+ *
+ * @return the boolean of the callback (true if the event occurs, false otherwise)
+ */
+ei_bool_t pan(ei_widget_t* w_viewer, ei_event_t* event, void* params);
+
+
+/**
+ * \brief the callback to end panning a viewer
+ *
+ * @param w_viewer : set to NULL
+ * @param event : the event telling the end of panning
+ * @param params : additionnal parameters the user can add
+ *
+ * @return the boolean of the callback (true if the event occurs, false otherwise)
+ */
+ei_bool_t end_pan(ei_widget_t* w_viewer, ei_event_t* event, void* params);
+
+
+#endif
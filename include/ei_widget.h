@@ -55,8 +55,8 @@ typedef void		(*ei_widget_destructor_t)(struct ei_widget_t* widget);
  */
 typedef struct ei_widget_t {
 	ei_widgetclass_t*	wclass;		///< The class of widget of this widget. Avoid the field name "class" which is a keyword in C++.
-	uint32_t		pick_id;	///< Id of this widget in the picking offscreen.
-	ei_color_t*		pick_color;	///< pick_id encoded as a color.
+	uint32_t		pick_id;	///< Id of this widget in the picking offscreen (ids of destroyed widgets are reused).
+	ei_color_t		pick_color;	///< pick_id encoded as a color.
 	void*			user_data;	///< Pointer provided by the programmer for private use. May be NULL.
 	ei_widget_destructor_t	destructor;	///< Pointer to the programmer's function to call before destroying this widget structure. May be NULL.
 
@@ -65,13 +65,24 @@ typedef struct ei_widget_t {
 	struct ei_widget_t*	children_head;	///< Pointer to the first child of this widget.	Children are chained with the "next_sibling" field.
 	struct ei_widget_t*	children_tail;	///< Pointer to the last child of this widget.
 	struct ei_widget_t*	next_sibling;	///< Pointer to the next child of this widget's parent widget.
+	struct ei_widget_t*	prev_sibling;	///< Pointer to the previous child of this widget's parent widget.
 
 	/* Geometry Management */
 	struct ei_geometry_param_t*
 				geom_params;	///< Pointer to the geometry management parameters for this widget. If NULL, the widget is not currently managed and thus, is not mapped on the screen.
 	ei_size_t		requested_size;	///< Size requested by the widget (big enough for its label, for example), or by the programmer. This can be different than its screen size defined by the placer.
-	ei_rect_t		screen_location;///< Position and size of the widget expressed in the root window reference.
+	ei_rect_t		screen_location;///< Position and size of the widget expressed in the root window reference. When an ancestor moves, it is only updated when the widget is drawn or picked (see \ref ei_geometrymanager_resolve).
 	ei_rect_t*		content_rect;	///< Where to place children, when this widget is used as a container. By defaults, points to the screen_location.
+	ei_rect_t		inner_rect;	///< The rect content_rect points to when it is not the screen_location (inside the border, for example).
+	ei_point_t		relative_position;///< Top left corner of the screen_location, relative to the top left corner of the content_rect of the parent.
+	ei_size_t		parent_size;	///< Size of the content_rect of the parent when the geometry manager computed the geometry.
+	ei_size_t		children_size;	///< Size of the content_rect when the children were last placed.
+	uint32_t		geom_version;	///< Incremented each time the content_rect moves.
+	uint32_t		parent_version;	///< The geom_version of the parent when the screen_location was last computed.
+	ei_bool_t		hidden;		///< The widget and its descendants are neither drawn nor picked, but keep their geometry (see \ref ei_widget_set_visible).
+
+	/* Memory Management */
+	struct ei_slab_t*	slab;		///< The slab this widget is allocated in (see \ref ei_slab_alloc), NULL if it was allocated by the allocfunc of its class.
 } ei_widget_t;
 
 
@@ -104,6 +115,39 @@ ei_widget_t*		ei_widget_create		(ei_widgetclass_name_t	class_name,
 void			ei_widget_destroy		(ei_widget_t*		widget);
 
 
+/**
+ * @brief	Moves a widget above its siblings: it is drawn after them, and picked before them
+ *		where they overlap. The resize button of a toplevel stays above the other
+ *		children of the toplevel. Only the parts of the screen where the widget overlaps
+ *		the siblings it goes above are drawn again.
+ *
+ * @param	widget		The widget to raise.
+ */
+void			ei_widget_raise			(ei_widget_t*		widget);
+
+
+/**
+ * @brief	Moves a widget below its siblings: it is drawn before them. Only the parts of the
+ *		screen where the widget overlaps the siblings it goes below are drawn again.
+ *
+ * @param	widget		The widget to lower.
+ */
+void			ei_widget_lower			(ei_widget_t*		widget);
+
+
+/**
+ * @brief	Shows or hides a widget and its descendants. A hidden widget is neither drawn nor
+ *		picked, but unlike \ref ei_geometrymanager_unmap it keeps its geometry
+ *		parameters (and its place is still computed): showing it again only draws again
+ *		the part of the screen it covers.
+ *
+ * @param	widget		The widget, not the root widget.
+ * @param	visible		EI_FALSE to hide the widget, EI_TRUE to show it (the default).
+ */
+void			ei_widget_set_visible		(ei_widget_t*		widget,
+							 ei_bool_t		visible);
+
+
 /**
  * @brief	Returns the widget that is at a given location on screen.
  *
@@ -149,7 +193,8 @@ ei_widget_t*		ei_widget_pick			(ei_point_t*		where);
  * @param	img		The image to display in the widget, or NULL. Any surface can be
  *				used, but usually a surface returned by \ref hw_image_load. Only one
  *				of the parameter "text" and "img" should be used (i.e. non-NULL).
- 				Defaults to NULL.
+ 				Defaults to NULL. The surface is shared with the widget, not copied:
+ *				the caller can drop its own reference with \ref ei_surface_release.
  * @param	img_rect	If not NULL, this rectangle defines a subpart of "img" to use as the
  *				image displayed in the widget. Defaults to NULL.
  * @param	img_anchor	The anchor of the image, i.e. where it is placed within the widget
@@ -237,5 +282,68 @@ void			ei_toplevel_configure		(ei_widget_t*		widget,
 							 ei_axis_set_t*		resizable,
 						 	 ei_size_t**		min_size);
 
+/**
+ * @brief	Configures the attributes of widgets of the class "viewer", which show images too
+ *		big to be kept in memory: the image is stored as a tile pyramid (see
+ *		\ref ei_tiles_open), and only the visible tiles of one level of the pyramid are
+ *		read. The user pans the image by dragging it with the mouse.
+ *
+ * @param	widget		The widget to configure.
+ * @param	requested_size	The size requested for this widget. Defaults to (320x240).
+ * @param	color		The color of the background, around the image. Defaults to
+ *				\ref ei_default_background_color.
+ * @param	filename	The name of the image file. Defaults to NULL (no image).
+ * @param	level		The level of the pyramid shown: 0 is the full resolution, each
+ *				next level halves it. Defaults to the first level which fits in
+ *				the widget.
+ * @param	offset		The pixel of the level shown at the top left corner of the widget.
+ *				Defaults to the one which centers the image.
+ */
+void			ei_viewer_configure		(ei_widget_t*		widget,
+							 ei_size_t*		requested_size,
+							 const ei_color_t*	color,
+							 char**			filename,
+							 int*			level,
+							 ei_point_t*		offset);
+
+
+/**
+ * @brief	Pans the image of a viewer: only the tiles which are not in the tile cache are read
+ *		from the pyramid at the next redraw.
+ *
+ * @param	widget		The viewer.
+ * @param	dx, dy		The move of the image, in pixels of the shown level.
+ */
+void			ei_viewer_pan			(ei_widget_t*		widget,
+							 int			dx,
+							 int			dy);
+
+
+/**
+ * @brief	Zooms the image of a viewer, by showing another level of its pyramid.
+ *
+ * @param	widget		The viewer.
+ * @param	levels		The number of levels to zoom in (each level doubles the size of the
+ *				image), negative to zoom out.
+ * @param	around		The point of the screen which stays on the same pixel of the image,
+ *				NULL for the center of the viewer.
+ */
+void			ei_viewer_zoom			(ei_widget_t*		widget,
+							 int			levels,
+							 const ei_point_t*	around);
+
+
+/**
+ * @brief	Sets how the image of a widget of the class "frame" or "button" is fitted in its
+ *		content: not scaled (the default), stretched, or in nine slices (the corners keep
+ *		their size, for backgrounds and borders). The scaled images are cached for each
+ *		size, so redrawing (or resizing back) a widget does not scale its image again.
+ *
+ * @param	widget		The frame or button.
+ * @param	scaling		The scaling (copied), NULL for \ref ei_image_natural.
+ */
+void			ei_widget_set_image_scaling	(ei_widget_t*			widget,
+							 const ei_image_scaling_t*	scaling);
+
 
 #endif
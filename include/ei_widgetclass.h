@@ -50,6 +50,7 @@ typedef void	(*ei_widgetclass_releasefunc_t)		(struct ei_widget_t*	widget);
  * @param	surface		Where to draw the widget. The actual location of the widget in the
  *				surface is stored in its "screen_location" field.
  * @param	pick_surface	The surface used for picking (i.e. find the widget below the mouse pointer).
+ *				NULL unless the application uses \ref ei_picking_offscreen.
  * @param	clipper		If not NULL, the drawing is restricted within this rectangle
  *				(expressed in the surface reference frame).
  */
@@ -138,6 +139,13 @@ void			ei_button_register_class 	(void);
  */
 void			ei_toplevel_register_class 	(void);
 
+/**
+ * \brief	Registers the "viewer" widget class in the program. This must be called only
+ *		once before widgets of the class "viewer" can be created and configured with
+ *		\ref ei_viewer_configure.
+ */
+void			ei_viewer_register_class 	(void);
+
 
 /* Inline function definitions. */
 
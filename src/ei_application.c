@@ -10,6 +10,7 @@
 #include "ei_frameclass.h"
 #include "ei_buttonclass.h"
 #include "ei_toplevelclass.h"
+#include "ei_viewerclass.h"
 #include "ei_geometrymanager.h"
 #include "ei_widget.h"
 #include "ei_types.h"
@@ -17,6 +18,17 @@
 #include "ei_draw_more.h"
 #include "ei_event_more.h"
 #include "ei_calculations.h"
+#include "ei_surface.h"
+#include "ei_kernels.h"
+#include "ei_picking.h"
+#include "ei_text_cache.h"
+#include "ei_pool.h"
+#include "ei_scale.h"
+#include "ei_decoration.h"
+#include "ei_slab.h"
+#include "ei_geometry_store.h"
+#include "ei_batch.h"
+#include "ei_image.h"
 #include <stdio.h>
 #include <unistd.h>
 
@@ -24,7 +36,8 @@
 /* root widget (usually the root window)*/
 static ei_frame_t *root_widget = NULL;
 static ei_surface_t root_surface;
-ei_surface_t pick_surface;
+/* how the widgets under the mouse are found */
+static ei_picking_mode_t picking_mode = ei_picking_offscreen;
 /* list of all the widget classes */
 extern ei_widgetclass_t *widclss_top;
 /* list of all the geometry managers */
@@ -37,10 +50,18 @@ static ei_bool_t run = EI_TRUE;
 static ei_bool_t resizing = EI_FALSE;
 
 
+void ei_app_set_picking_mode(ei_picking_mode_t mode) {
+	picking_mode = mode;
+}
+
+
 void ei_app_create(ei_size_t main_window_size, ei_bool_t fullscreen) {
 	/* hardware initialisation */
 	hw_init();
 
+	/* drawing kernels for this processor */
+	ei_kernels_init();
+
 	/* root window creation */
 	root_surface = hw_create_window(main_window_size, fullscreen);
 
@@ -51,6 +72,7 @@ void ei_app_create(ei_size_t main_window_size, ei_bool_t fullscreen) {
 	ei_frame_register_class();
 	ei_button_register_class();
 	ei_toplevel_register_class();
+	ei_viewer_register_class();
 
 	/* defines the root window as the root widget (of class frame) */
 	root_widget = (ei_frame_t*)ei_widget_create("frame", NULL, NULL, NULL);
@@ -65,8 +87,13 @@ void ei_app_create(ei_size_t main_window_size, ei_bool_t fullscreen) {
 	ei_frame_configure((ei_widget_t*)root_widget, &main_window_size, &ei_default_background_color, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
 
 	root_widget->widget.screen_location = root_screen_location;
+	ei_geometry_store_update((ei_widget_t*)root_widget);
+
+	/* pick surface or spatial index, depending on the picking mode */
+	ei_picking_init(root_surface, hw_surface_get_size(root_surface), picking_mode);
 
-	pick_surface = hw_surface_create(root_surface, main_window_size, EI_FALSE);
+	/* Binding for raising the clicked toplevels, first so that no callback consumes the event */
+	ei_bind(ei_ev_mouse_buttondown, NULL, "all", raise_toplevel, NULL);
 
 	/* Binding all buttons (for their animations) */
 	ei_bind(ei_ev_mouse_buttondown, NULL, "button", ei_handle_button_down, NULL);
@@ -80,6 +107,11 @@ void ei_app_create(ei_size_t main_window_size, ei_bool_t fullscreen) {
 	/* Binding for moving events */
 	ei_bind(ei_ev_mouse_buttonup, NULL, "all", end_move, NULL);
 	ei_bind(ei_ev_mouse_move, NULL, "all", move, NULL);
+
+	/* Binding for panning the viewers */
+	ei_bind(ei_ev_mouse_buttondown, NULL, "viewer", beg_pan, NULL);
+	ei_bind(ei_ev_mouse_buttonup, NULL, "all", end_pan, NULL);
+	ei_bind(ei_ev_mouse_move, NULL, "all", pan, NULL);
 }
 
 
@@ -95,14 +127,25 @@ void ei_draw_widget_children(ei_widget_t* widget, ei_rect_t* parent_clipper) {
 	ei_widget_t * current_draw = widget->children_head;
 
 	/* stops to draw if all the children have been drawn, or if there is no child */
+	const ei_geometry_store_t *store = ei_geometry_store();
 	while(current_draw) {
-		/* Do not draw the widget if it does not have geometry parameters */
-		if(current_draw->geom_params) {
-			/* Run the widget's geometry manager */
-			current_draw->geom_params->manager->runfunc(current_draw);
+		/* Do not draw the widget if it does not have geometry parameters, or if it is hidden */
+		if(current_draw->geom_params && !current_draw->hidden) {
+			/* Moves the widget if its ancestors moved */
+			ei_geometrymanager_resolve(current_draw);
+			ei_geometry_store_update(current_draw);
+
+			/* skips the widget and its children if it is outside of the clipper (its children
+			   are clipped by its content), unless it is not clipped by its parent */
+			const uint32_t slot = current_draw->pick_id;
+			ei_rect_t visible = get_ei_rect_intersection(*parent_clipper, store->bounds[slot]);
+			if((visible.size.width <= 0 || visible.size.height <= 0) && !(store->flags[slot] & ei_geometry_unclipped)) {
+				current_draw = current_draw->next_sibling;
+				continue;
+			}
 
 			/* calls the draw function of the widget to draw */
-			current_draw->wclass->drawfunc(current_draw, ei_app_root_surface(), pick_surface, parent_clipper);
+			current_draw->wclass->drawfunc(current_draw, ei_app_root_surface(), ei_picking_surface(), parent_clipper);
 
 			/* Computes clipper for the current widget */
 			ei_rect_t current_clipper = get_ei_rect_intersection(*parent_clipper, *current_draw->content_rect);
@@ -131,15 +174,18 @@ void initialDraw() {
 
 		/* Locks root's surface */
 		hw_surface_lock(ei_app_root_surface());
-		hw_surface_lock(pick_surface);
+		if(ei_picking_surface())
+			hw_surface_lock(ei_picking_surface());
 
 		/* draw the root and all its children */
-		root->wclass->drawfunc(root, ei_app_root_surface(), pick_surface, frame_root->widget.content_rect);
+		root->wclass->drawfunc(root, ei_app_root_surface(), ei_picking_surface(), frame_root->widget.content_rect);
 		ei_draw_widget_children(root, frame_root->widget.content_rect);
+		ei_picking_update(NULL);
 
 		/* Unlocks root's surface */
 		hw_surface_unlock(ei_app_root_surface());
-		hw_surface_unlock(pick_surface);
+		if(ei_picking_surface())
+			hw_surface_unlock(ei_picking_surface());
 		
 		/* upadtes the rectangles to draw because of a bug (AUR machines do not seem to sync the code and the graphic card) */
 		for(int i = 0; i < 10; i++) {
@@ -150,62 +196,14 @@ void initialDraw() {
 }
 
 
-ei_bool_t is_under_mouse(ei_widget_t* widget, ei_point_t mouse_pos, ei_surface_t pick_surface) {
-	/**
-	 *	Checks if 'widget' is under 'mouse_pos' according to 'pick_surface'
-	 */
-
-	/* Gets the pick_surface's pixel color under the mouse */
-	uint32_t* pixel_ptr = (uint32_t *) hw_surface_get_buffer(pick_surface);
-	ei_size_t pick_size = hw_surface_get_size(pick_surface); 
-	pixel_ptr += mouse_pos.x + mouse_pos.y * pick_size.width;
-
-	/* Returns true if the color is the same as the widget color */
-	return (ei_bool_t) *pixel_ptr == ei_map_rgba(pick_surface, widget->pick_color);
-}
-
-ei_widget_t *find_picked_in_children(ei_widget_t *parent, uint32_t pick_color, ei_surface_t pick_surface) {
-	/**
-	 *	Returns the widget that is under 'mouse_pos' according to 'pick_surface' that is parent or one of it's children.
-	 *	Returns NULL if no widget is found.
-	 */
-	
-	/* Checks if the parent matches */
-	if(pick_color == ei_map_rgba(pick_surface, parent->pick_color))
-		return parent;
-
-	/* Navigator through the parent's direct children */
-	ei_widget_t* curr_test = parent->children_head;
-	/* Go through the parent's direct children linked list */
-	while(curr_test) {
-		/* Try to find the matching widget */
-		ei_widget_t* ret = find_picked_in_children(curr_test, pick_color, pick_surface);
-
-		/* If it is found, return it */
-		if(ret)
-			return ret;
-
-		/* Else continue */
-		curr_test = curr_test->next_sibling;
-	}
-
-	/* If no widget was found, returns NULL */
-	return NULL;
-}
-
-ei_widget_t *find_picked_tagged_widget(ei_point_t mouse_pos,ei_surface_t pick_surface, ei_tag_t tag) {
+ei_widget_t *find_picked_tagged_widget(ei_point_t mouse_pos, ei_tag_t tag) {
 	/**
-	 *	Returns the widget that is under 'mouse_pos' according to 'pick_surface' that matches 'tag' 
+	 *	Returns the widget that is under 'mouse_pos' that matches 'tag' 
 	 * 	Returns NULL if no widget is found.
 	 */
 
-	/* Gets the pick_surface's pixel colot under the mouse */
-	uint32_t* pixel_ptr = (uint32_t *) hw_surface_get_buffer(pick_surface);
-	ei_size_t pick_size = hw_surface_get_size(pick_surface); 
-	pixel_ptr += mouse_pos.x + mouse_pos.y * pick_size.width;
-
 	/* Get the widget under 'mouse_pos' */
-	ei_widget_t *found = find_picked_in_children(ei_app_root_widget(), *pixel_ptr, pick_surface);
+	ei_widget_t *found = ei_picking_find(mouse_pos);
 
 	/* Returns this widget if its tag correspond or if the requested tag is "all" */
 	if(found && (!strcmp(tag, "all") || !strcmp(tag, found->wclass->name)))
@@ -265,8 +263,9 @@ void ei_app_run() {
 		/* Navigator through the binded events linked list */
 		ei_linked_binded_event *current_bind = get_top_event_bind();
 
-		/* True if the current event has been processed and the loop should stop */
-		ei_bool_t processed = EI_FALSE;
+		/* True if the current event has been processed and the loop should stop
+		   (the images decoded in the background are handled first) */
+		ei_bool_t processed = (event.type == ei_ev_app) ? ei_image_handle_event(&event) : EI_FALSE;
 
 		/* Go through the binded events linked list */
 		while(!processed && current_bind) {
@@ -278,14 +277,14 @@ void ei_app_run() {
 				if(current_bind->widget) { 
 
 					/* ..., then we run the event if it is not localised or if the widget is under the mouse. */ 
-				    if(!current_bind->pickable || is_under_mouse(current_bind->widget, event.param.mouse.where, pick_surface))
+				    if(!current_bind->pickable || ei_picking_is_under(current_bind->widget, event.param.mouse.where))
 						processed = current_bind->callback(current_bind->widget, &event, current_bind->user_param);
 				/* ..., if the target is a tag ... */	
 				} else if (current_bind->tag) {
 					/* Find targeted widget */
 					ei_widget_t *to_callback = NULL;
 					if(current_bind->pickable) {
-						to_callback = find_picked_tagged_widget(event.param.mouse.where, pick_surface, current_bind->tag);
+						to_callback = find_picked_tagged_widget(event.param.mouse.where, current_bind->tag);
 					} else
 						to_callback = find_unlocalised_tagged_widget(ei_app_root_widget(), current_bind->tag);
 
@@ -299,21 +298,27 @@ void ei_app_run() {
 			current_bind = current_bind->next;
 		}
 
+		/* frees the events binded to the widgets destroyed by the callbacks */
+		ei_event_sweep();
+
 		/* Redraws invalidated_rects */
 		ei_linked_rect_t * current_invalidated_rect = invalidated_rects;
 		if(!current_invalidated_rect)
 			continue;
 
 		hw_surface_lock(ei_app_root_surface());
-		hw_surface_lock(pick_surface);
+		if(ei_picking_surface())
+			hw_surface_lock(ei_picking_surface());
 		while(current_invalidated_rect) {
-			ei_app_root_widget()->wclass->drawfunc(ei_app_root_widget(), ei_app_root_surface(), pick_surface, &current_invalidated_rect->rect);
+			ei_app_root_widget()->wclass->drawfunc(ei_app_root_widget(), ei_app_root_surface(), ei_picking_surface(), &current_invalidated_rect->rect);
 			ei_draw_widget_children(ei_app_root_widget(), &current_invalidated_rect->rect);
 			current_invalidated_rect = current_invalidated_rect->next;
 		}
+		ei_picking_update(invalidated_rects);
 
 		hw_surface_unlock(ei_app_root_surface());
-		hw_surface_unlock(pick_surface);
+		if(ei_picking_surface())
+			hw_surface_unlock(ei_picking_surface());
 
 		hw_surface_update_rects(ei_app_root_surface(), invalidated_rects);
 
@@ -330,11 +335,18 @@ void ei_app_run() {
 }
 
 void ei_app_invalidate_rect(ei_rect_t* rect) {
+	/* what needs a redraw may also have moved: the spatial index of the picking is outdated */
+	ei_picking_invalidate();
+
+	normalize_rect(rect, ei_app_root_widget()->screen_location.size);
+	/* inside a batch, the rects are merged and added at the commit */
+	if(ei_batch_defer_invalidate(rect))
+		return;
+
 	/* linked_rect to add to the list (a struct having a rect and a next rect)*/
 	ei_linked_rect_t* rect_to_invalidate = malloc(sizeof(ei_linked_rect_t));
 
 	/* as told in the header, the rect we add to the list is a copy of the rect given */
-	normalize_rect(rect, ei_app_root_widget()->screen_location.size);
 	rect_to_invalidate->rect = *rect;
 	rect_to_invalidate->next = NULL;
 
@@ -408,6 +420,9 @@ void ei_app_free() {
 		current_rect = next_rect;
 	}
 
+	/* Unbinding for raising the clicked toplevels */
+	ei_unbind(ei_ev_mouse_buttondown, NULL, "all", raise_toplevel, NULL);
+
 	/* Unbinding all buttons (for their animations) */
 	ei_unbind(ei_ev_mouse_buttondown, NULL, "button", ei_handle_button_down, NULL);
 	ei_unbind(ei_ev_mouse_buttonup, NULL, "all", ei_handle_button_up, NULL);
@@ -421,6 +436,11 @@ void ei_app_free() {
 	ei_unbind(ei_ev_mouse_buttonup, NULL, "all", end_move, NULL);
 	ei_unbind(ei_ev_mouse_move, NULL, "all", move, NULL);
 
+	/* Unbinding for panning the viewers */
+	ei_unbind(ei_ev_mouse_buttondown, NULL, "viewer", beg_pan, NULL);
+	ei_unbind(ei_ev_mouse_buttonup, NULL, "all", end_pan, NULL);
+	ei_unbind(ei_ev_mouse_move, NULL, "all", pan, NULL);
+
 	ei_linked_binded_event *current_bind = get_top_event_bind();
 	ei_linked_binded_event *next_bind;
 	while(current_bind){
@@ -429,8 +449,16 @@ void ei_app_free() {
 		current_bind = next_bind;
 	}
 
-	hw_surface_free(ei_app_root_surface());
-	hw_surface_free(pick_surface);
+	ei_image_cache_free();
+	ei_picking_free();
+	ei_text_cache_free();
+	ei_scale_cache_free();
+	ei_decoration_cache_free();
+	ei_geometry_store_free();
+	ei_batch_free();
+	ei_slab_free_all();
+	ei_pool_free();
+	ei_surface_free(ei_app_root_surface());
 
 	/* hardware ending */
 	hw_quit();
@@ -0,0 +1,195 @@
+/**
+ *  @file	ei_atlas.c
+ *  @brief	Atlases: many small images packed in one surface (skyline packing), used by the
+ *		widgets through the rectangle of each image.
+ *
+ */
+
+#include "ei_atlas.h"
+#include "ei_application.h"
+#include "ei_surface.h"
+#include "ei_image.h"
+#include "ei_draw.h"
+#include "ei_kernels.h"
+#include <stdlib.h>
+#include <math.h>
+
+
+/* A segment of the skyline: the top of the packed images from x to x + width is at y */
+typedef struct ei_skyline_t {
+	int	x;
+	int	y;
+	int	width;
+} ei_skyline_t;
+
+
+ei_atlas_t* ei_atlas_create(void) {
+	return calloc(1, sizeof(ei_atlas_t));
+}
+
+
+int ei_atlas_add(ei_atlas_t* atlas, ei_surface_t image) {
+	if(atlas->images_nb == atlas->images_size) {
+		atlas->images_size = atlas->images_size ? 2 * atlas->images_size : 16;
+		atlas->images = realloc(atlas->images, atlas->images_size * sizeof(ei_surface_t));
+		atlas->rects = realloc(atlas->rects, atlas->images_size * sizeof(ei_rect_t));
+	}
+	ei_surface_retain(image);
+	atlas->images[atlas->images_nb] = image;
+	atlas->rects[atlas->images_nb] = (ei_rect_t){{0, 0}, hw_surface_get_size(image)};
+	return atlas->images_nb++;
+}
+
+
+int ei_atlas_add_file(ei_atlas_t* atlas, const char* filename) {
+	ei_surface_t image = ei_image_load(filename);
+	if(!image)
+		return -1;
+	int index = ei_atlas_add(atlas, image);
+	ei_surface_release(image);
+	return index;
+}
+
+
+/* the segment where a w x h block has the lowest top (then the leftmost one), and this top */
+static int find_place(const ei_skyline_t* sky, int sky_nb, int atlas_width, int w, int* best_y) {
+	int best = -1;
+	*best_y = 0;
+	for(int i = 0; i < sky_nb && sky[i].x + w <= atlas_width; i++) {
+		/* the block rests on the highest segment below it */
+		int y = 0;
+		for(int j = i, left = w; left > 0; left -= sky[j].width, j++)
+			y = sky[j].y > y ? sky[j].y : y;
+		if(best < 0 || y < *best_y) {
+			best = i;
+			*best_y = y;
+		}
+	}
+	return best;
+}
+
+
+/* raises the skyline over a block placed at sky[i].x */
+static int add_block(ei_skyline_t* sky, int sky_nb, int i, int w, int top) {
+	ei_skyline_t block = {sky[i].x, top, w};
+	int end = block.x + w;
+
+	/* removes the segments covered by the block, cuts the last one */
+	int j = i;
+	while(j < sky_nb && sky[j].x + sky[j].width <= end)
+		j++;
+	if(j < sky_nb && sky[j].x < end) {
+		sky[j].width -= end - sky[j].x;
+		sky[j].x = end;
+	}
+	int removed = j - i;
+	if(removed == 0) {
+		for(int k = sky_nb; k > i; k--)
+			sky[k] = sky[k - 1];
+		sky_nb++;
+	} else {
+		for(int k = i + 1; k + removed - 1 < sky_nb; k++)
+			sky[k] = sky[k + removed - 1];
+		sky_nb -= removed - 1;
+	}
+	sky[i] = block;
+
+	/* merges the neighbours of same height */
+	for(int k = 0; k + 1 < sky_nb; ) {
+		if(sky[k].y == sky[k + 1].y) {
+			sky[k].width += sky[k + 1].width;
+			for(int m = k + 1; m + 1 < sky_nb; m++)
+				sky[m] = sky[m + 1];
+			sky_nb--;
+		} else
+			k++;
+	}
+	return sky_nb;
+}
+
+
+static int by_height(const void* a, const void* b) {
+	const ei_rect_t *ra = *(const ei_rect_t * const *)a;
+	const ei_rect_t *rb = *(const ei_rect_t * const *)b;
+	if(ra->size.height != rb->size.height)
+		return rb->size.height - ra->size.height;
+	return rb->size.width - ra->size.width;
+}
+
+
+ei_bool_t ei_atlas_build(ei_atlas_t* atlas) {
+	const int pad = EI_ATLAS_PADDING;
+	const int n = atlas->images_nb;
+	if(atlas->surface || n <= 0)
+		return atlas->surface ? EI_TRUE : EI_FALSE;
+
+	/* width: about the square root of the area, at least the widest image */
+	long area = 0;
+	int width = 0;
+	for(int i = 0; i < n; i++) {
+		ei_size_t s = atlas->rects[i].size;
+		area += (long)(s.width + 2 * pad) * (s.height + 2 * pad);
+		width = (s.width + 2 * pad > width) ? s.width + 2 * pad : width;
+	}
+	int side = (int)ceil(sqrt((double)area));
+	width = side > width ? side : width;
+
+	/* places the tallest images first */
+	ei_rect_t **order = malloc((size_t)n * sizeof(ei_rect_t *));
+	for(int i = 0; i < n; i++)
+		order[i] = &atlas->rects[i];
+	qsort(order, n, sizeof(ei_rect_t *), by_height);
+
+	ei_skyline_t *sky = malloc((2 * (size_t)n + 1) * sizeof(ei_skyline_t));
+	int sky_nb = 1;
+	sky[0] = (ei_skyline_t){0, 0, width};
+	int height = 0;
+	for(int i = 0; i < n; i++) {
+		int w = order[i]->size.width + 2 * pad;
+		int h = order[i]->size.height + 2 * pad;
+		int y;
+		int place = find_place(sky, sky_nb, width, w, &y);
+		order[i]->top_left = (ei_point_t){sky[place].x + pad, y + pad};
+		sky_nb = add_block(sky, sky_nb, place, w, y + h);
+		height = (y + h > height) ? y + h : height;
+	}
+	free(sky);
+	free(order);
+
+	/* copies the images (the padding stays transparent) */
+	atlas->surface = hw_surface_create(ei_app_root_surface(), (ei_size_t){width, height}, EI_TRUE);
+	if(!atlas->surface)
+		return EI_FALSE;
+	hw_surface_lock(atlas->surface);
+	ei_surface_desc_t desc = ei_surface_desc(atlas->surface);
+	ei_kernels()->fill(desc.pixels, desc.pitch, width, height, 0);
+	for(int i = 0; i < n; i++) {
+		hw_surface_lock(atlas->images[i]);
+		ei_copy_surface(atlas->surface, &atlas->rects[i], atlas->images[i], NULL, EI_FALSE);
+		hw_surface_unlock(atlas->images[i]);
+		ei_surface_release(atlas->images[i]);
+	}
+	hw_surface_unlock(atlas->surface);
+	free(atlas->images);
+	atlas->images = NULL;
+
+	ei_image_scan_opacity(atlas->surface);
+	return EI_TRUE;
+}
+
+
+ei_rect_t* ei_atlas_rect(ei_atlas_t* atlas, int index) {
+	return &atlas->rects[index];
+}
+
+
+void ei_atlas_free(ei_atlas_t* atlas) {
+	if(atlas->images)
+		for(int i = 0; i < atlas->images_nb; i++)
+			ei_surface_release(atlas->images[i]);
+	if(atlas->surface)
+		ei_surface_release(atlas->surface);
+	free(atlas->images);
+	free(atlas->rects);
+	free(atlas);
+}
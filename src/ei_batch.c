@@ -0,0 +1,169 @@
+/**
+ *  @file	ei_batch.c
+ *  @brief	Batches of updates of the widgets: between \ref ei_batch_begin and
+ *		\ref ei_batch_commit, the placement of the widgets and the rectangles to redraw
+ *		are recorded instead of being computed at each call, and resolved once at the end.
+ *
+ */
+
+#include "ei_batch.h"
+#include "ei_application.h"
+#include "ei_geometrymanager.h"
+#include "ei_picking.h"
+#include "ei_calculations.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/* a widget to lay out, and its depth in the tree */
+typedef struct ei_batch_layout_t {
+	uint32_t	id;		///< The pick id of the widget.
+	int		depth;		///< Number of its ancestors.
+} ei_batch_layout_t;
+
+
+static int depth = 0;			///< Number of open batches.
+static ei_bool_t resolving = EI_FALSE;	///< The outermost batch is being committed.
+
+/* the widgets to lay out, by pick id (the widgets may be destroyed during the batch) */
+static uint32_t *pending = NULL;
+static uint32_t pending_nb = 0;
+static uint32_t pending_size = 0;
+static uint8_t *marks = NULL;		///< Whether a pick id is in pending.
+static uint32_t marks_size = 0;
+
+/* the rectangles to redraw, none of them containing another one */
+static ei_rect_t damage[EI_BATCH_MAX_DAMAGE];
+static int damage_nb = 0;
+
+
+void ei_batch_begin(void) {
+	depth++;
+}
+
+
+ei_bool_t ei_batch_defer_layout(ei_widget_t* widget) {
+	const uint32_t id = widget->pick_id;
+	if(!depth || resolving) {
+		/* laid out now, by the commit or a geomnotifyfunc: the commit skips it */
+		if(id < marks_size)
+			marks[id] = 0;
+		return EI_FALSE;
+	}
+
+	if(id >= marks_size) {
+		uint32_t size = marks_size ? marks_size : 64;
+		while(size <= id)
+			size *= 2;
+		marks = realloc(marks, size);
+		memset(marks + marks_size, 0, size - marks_size);
+		marks_size = size;
+	}
+	if(marks[id])
+		return EI_TRUE;
+	if(pending_nb == pending_size) {
+		pending_size = pending_size ? 2 * pending_size : 64;
+		pending = realloc(pending, pending_size * sizeof(uint32_t));
+	}
+	pending[pending_nb++] = id;
+	marks[id] = 1;
+	return EI_TRUE;
+}
+
+
+static ei_bool_t rect_contains(ei_rect_t outer, const ei_rect_t* inner) {
+	return	inner->top_left.x >= outer.top_left.x &&
+		inner->top_left.y >= outer.top_left.y &&
+		inner->top_left.x + inner->size.width <= outer.top_left.x + outer.size.width &&
+		inner->top_left.y + inner->size.height <= outer.top_left.y + outer.size.height;
+}
+
+
+ei_bool_t ei_batch_defer_invalidate(const ei_rect_t* rect) {
+	if(!depth)
+		return EI_FALSE;
+	if(rect->size.width <= 0 || rect->size.height <= 0)
+		return EI_TRUE;
+
+	int i = 0;
+	while(i < damage_nb) {
+		if(rect_contains(damage[i], rect))
+			return EI_TRUE;
+		if(rect_contains(*rect, &damage[i]))
+			damage[i] = damage[--damage_nb];
+		else
+			i++;
+	}
+	if(damage_nb == EI_BATCH_MAX_DAMAGE) {
+		for(i = 1; i < damage_nb; i++)
+			damage[0] = get_ei_rect_union(damage[0], damage[i]);
+		damage[0] = get_ei_rect_union(damage[0], *rect);
+		damage_nb = 1;
+		return EI_TRUE;
+	}
+	damage[damage_nb++] = *rect;
+	return EI_TRUE;
+}
+
+
+static int compare_depths(const void* a, const void* b) {
+	return ((const ei_batch_layout_t*)a)->depth - ((const ei_batch_layout_t*)b)->depth;
+}
+
+
+void ei_batch_commit(void) {
+	if(!depth)
+		return;
+	if(depth > 1) {
+		depth--;
+		return;
+	}
+
+	/* the parents first: when their geometry changes, their geomnotifyfunc lays out their
+	   children, which are then unmarked */
+	ei_batch_layout_t *layouts = malloc(pending_nb * sizeof(ei_batch_layout_t));
+	uint32_t layouts_nb = 0;
+	for(uint32_t i = 0; i < pending_nb; i++) {
+		ei_widget_t *widget = ei_picking_widget(pending[i]);
+		if(!widget)
+			continue;
+		int widget_depth = 0;
+		for(ei_widget_t *ancestor = widget->parent; ancestor; ancestor = ancestor->parent)
+			widget_depth++;
+		layouts[layouts_nb++] = (ei_batch_layout_t){pending[i], widget_depth};
+	}
+	qsort(layouts, layouts_nb, sizeof(ei_batch_layout_t), compare_depths);
+
+	/* the rectangles invalidated by the layout are still merged */
+	resolving = EI_TRUE;
+	for(uint32_t i = 0; i < layouts_nb; i++) {
+		if(!marks[layouts[i].id])
+			continue;
+		ei_widget_t *widget = ei_picking_widget(layouts[i].id);
+		marks[layouts[i].id] = 0;
+		if(widget && widget->geom_params)
+			widget->geom_params->manager->runfunc(widget);
+	}
+	resolving = EI_FALSE;
+	free(layouts);
+	for(uint32_t i = 0; i < pending_nb; i++)
+		marks[pending[i]] = 0;
+	pending_nb = 0;
+
+	depth = 0;
+	for(int i = 0; i < damage_nb; i++)
+		ei_app_invalidate_rect(&damage[i]);
+	damage_nb = 0;
+}
+
+
+void ei_batch_free(void) {
+	free(pending);
+	free(marks);
+	pending = NULL;
+	marks = NULL;
+	pending_nb = pending_size = marks_size = 0;
+	damage_nb = 0;
+	depth = 0;
+	resolving = EI_FALSE;
+}
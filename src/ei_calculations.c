@@ -54,6 +54,22 @@ ei_rect_t get_ei_rect_intersection(ei_rect_t rect1, ei_rect_t rect2){
 }
 
 
+ei_rect_t get_ei_rect_union(ei_rect_t rect1, ei_rect_t rect2) {
+    if(rect1.size.width <= 0 || rect1.size.height <= 0)
+        return rect2;
+    if(rect2.size.width <= 0 || rect2.size.height <= 0)
+        return rect1;
+
+    ei_rect_t bounds;
+    bounds.top_left.x = min(rect1.top_left.x, rect2.top_left.x);
+    bounds.top_left.y = min(rect1.top_left.y, rect2.top_left.y);
+    bounds.size.width = max(rect1.top_left.x + rect1.size.width, rect2.top_left.x + rect2.size.width) - bounds.top_left.x;
+    bounds.size.height = max(rect1.top_left.y + rect1.size.height, rect2.top_left.y + rect2.size.height) - bounds.top_left.y;
+
+    return bounds;
+}
+
+
 void normalize_rect(ei_rect_t *rect, ei_size_t window_size) {
 	rect->size.width += min(0, rect->top_left.x);
 	rect->size.height += min(0, rect->top_left.y);
@@ -0,0 +1,223 @@
+/**
+ *  @file	ei_decoration.c
+ *  @brief	Cache of the rendered decorations of the frames and buttons (the relief around the
+ *		content): the corners are rasterized once for each corner radius, border width,
+ *		relief and color, then a decoration is drawn by copying its 4 corners and filling
+ *		the rectangles of its edges and of its center.
+ *
+ */
+
+#include "ei_decoration.h"
+#include "ei_draw_more.h"
+#include "ei_calculations.h"
+#include "ei_surface.h"
+#include "ei_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/* A rendered decoration */
+typedef struct ei_decoration_entry_t {
+	int				corner_radius;	///< The radius of the corners (key).
+	int				border_width;	///< The width of the border (key).
+	ei_relief_t			relief;		///< The relief (key).
+	ei_color_t			color;		///< The color (key).
+	ei_color_t			top_color;	///< The color of the top and left borders.
+	ei_color_t			bottom_color;	///< The color of the bottom and right borders.
+	ei_surface_desc_t		desc;		///< The decoration of a square just bigger than its 4
+							///< corners, in a buffer of the pool.
+	int*				spans;		///< For each row of the square, the first column and the
+							///< column after the last one inside the rounded corners.
+	struct ei_decoration_entry_t*	newer;		///< Entry used just after this one.
+	struct ei_decoration_entry_t*	older;		///< Entry used just before this one.
+} ei_decoration_entry_t;
+
+
+/* the entries, from the most recently used to the least recently used */
+static ei_decoration_entry_t *newest = NULL;
+static ei_decoration_entry_t *oldest = NULL;
+static int entries_nb = 0;
+
+
+static void unlink_lru(ei_decoration_entry_t* entry) {
+	if(entry->newer)
+		entry->newer->older = entry->older;
+	else
+		newest = entry->older;
+	if(entry->older)
+		entry->older->newer = entry->newer;
+	else
+		oldest = entry->newer;
+}
+
+
+static void link_newest(ei_decoration_entry_t* entry) {
+	entry->newer = NULL;
+	entry->older = newest;
+	if(newest)
+		newest->newer = entry;
+	else
+		oldest = entry;
+	newest = entry;
+}
+
+
+static void remove_entry(ei_decoration_entry_t* entry) {
+	unlink_lru(entry);
+	entries_nb--;
+	ei_pool_put(entry->desc.pixels);
+	free(entry->spans);
+	free(entry);
+}
+
+
+/* rasterizes the decoration of a square of side 2 * (border_width + corner_radius + 1), as
+   drawframebuttonclasses draws it with polygons: its corners are the ones of any bigger widget */
+static ei_bool_t render(ei_decoration_entry_t* entry, ei_surface_t like) {
+	const int side = 2 * (entry->border_width + entry->corner_radius + 1);
+	ei_surface_t surface = hw_surface_create(like, (ei_size_t){side, side}, EI_TRUE);
+	if(!surface)
+		return EI_FALSE;
+
+	/* transparent around the rounded corners */
+	const ei_color_t transparent = {0, 0, 0, 0};
+	hw_surface_lock(surface);
+	ei_fill(surface, &transparent, NULL);
+	const ei_rect_t rect = {{0, 0}, {side, side}};
+	const ei_rect_t content = {{entry->border_width, entry->border_width},
+				   {side - 2 * entry->border_width, side - 2 * entry->border_width}};
+	ei_linked_point_t *high = ei_rounded_frame_high(rect, entry->corner_radius);
+	ei_linked_point_t *low = ei_rounded_frame_low(rect, entry->corner_radius);
+	ei_linked_point_t *all = ei_rounded_frame_all(content, entry->corner_radius);
+	ei_draw_polygon(surface, high, entry->top_color, &rect);
+	ei_draw_polygon(surface, low, entry->bottom_color, &rect);
+	ei_draw_polygon(surface, all, entry->color, &content);
+	ei_free_linked_points_list(high);
+	ei_free_linked_points_list(low);
+	ei_free_linked_points_list(all);
+
+	/* the pixels are kept in the channel order of the surfaces the decorations are drawn on */
+	const ei_surface_desc_t desc = ei_surface_desc(surface);
+	entry->desc = desc;
+	entry->desc.format = ei_surface_desc(like).format;
+	entry->desc.pixels = ei_pool_get(side, side, 4, &entry->desc.pitch);
+	entry->spans = malloc(2 * (size_t)side * sizeof(int));
+	if(entry->desc.pixels && entry->spans) {
+		for(int y = 0; y < side; y++) {
+			memcpy(EI_PIXEL_AT(&entry->desc, 0, y), EI_PIXEL_AT(&desc, 0, y), (size_t)side * 4);
+			/* the decoration is convex: the pixels drawn in a row are contiguous */
+			const uint8_t *alpha = (const uint8_t *)EI_PIXEL_AT(&desc, 0, y) + desc.format->ia;
+			int x0 = 0, x1 = side;
+			while(x0 < x1 && !alpha[4 * x0])
+				x0++;
+			while(x1 > x0 && !alpha[4 * (x1 - 1)])
+				x1--;
+			entry->spans[2 * y] = x0;
+			entry->spans[2 * y + 1] = x1;
+		}
+	}
+	hw_surface_unlock(surface);
+	ei_surface_free(surface);
+	if(!entry->desc.pixels || !entry->spans) {
+		ei_pool_put(entry->desc.pixels);
+		free(entry->spans);
+		return EI_FALSE;
+	}
+	return EI_TRUE;
+}
+
+
+static const ei_decoration_entry_t* get(int corner_radius, int border_width, ei_relief_t relief,
+					ei_color_t color, ei_surface_t like) {
+	for(ei_decoration_entry_t *entry = newest; entry; entry = entry->older) {
+		if(entry->corner_radius == corner_radius && entry->border_width == border_width &&
+		   entry->relief == relief && entry->color.red == color.red &&
+		   entry->color.green == color.green && entry->color.blue == color.blue) {
+			/* becomes the most recently used */
+			unlink_lru(entry);
+			link_newest(entry);
+			return entry;
+		}
+	}
+
+	/* first drawing of this decoration */
+	ei_decoration_entry_t *entry = calloc(1, sizeof(ei_decoration_entry_t));
+	entry->corner_radius = corner_radius;
+	entry->border_width = border_width;
+	entry->relief = relief;
+	entry->color = color;
+	ei_relief_colors(color, relief, &entry->top_color, &entry->bottom_color);
+	if(!render(entry, like)) {
+		free(entry);
+		return NULL;
+	}
+	link_newest(entry);
+	entries_nb++;
+	if(entries_nb > EI_DECORATION_CACHE_ENTRIES)
+		remove_entry(oldest);
+	return entry;
+}
+
+
+ei_bool_t ei_decoration_draw(ei_surface_t surface, ei_rect_t rect, int corner_radius, int border_width,
+			     ei_relief_t relief, ei_color_t color, const ei_rect_t* clipper) {
+	/* the corners must not overlap, and the content must be big enough for its rounded corners */
+	const int c = border_width + corner_radius;
+	if(color.alpha != 255 || border_width <= 0 || corner_radius < 0 ||
+	   rect.size.width < 2 * (c + 1) || rect.size.height < 2 * (c + 1))
+		return EI_FALSE;
+
+	const ei_surface_desc_t dst = ei_surface_desc(surface);
+	const ei_rect_t clip = get_ei_rect_intersection(*clipper, (ei_rect_t){{0, 0}, dst.size});
+	if(clip.size.width <= 0 || clip.size.height <= 0)
+		return EI_TRUE;
+	const ei_decoration_entry_t *entry = get(corner_radius, border_width, relief, color, surface);
+	if(!entry)
+		return EI_FALSE;
+
+	/* the 4 corners, copied row by row without the pixels outside the rounded corners */
+	const int x = rect.top_left.x, y = rect.top_left.y;
+	const int w = rect.size.width, h = rect.size.height;
+	const int side = entry->desc.size.width;
+	for(int i = 0; i < 4; i++) {
+		const int right = i & 1, bottom = i >> 1;
+		const ei_point_t where = {right ? x + w - c : x, bottom ? y + h - c : y};
+		const ei_point_t from = {right ? side - c : 0, bottom ? side - c : 0};
+		for(int row = 0; row < c; row++) {
+			const int *span = entry->spans + 2 * (from.y + row);
+			const int x0 = max(span[0], from.x) - from.x;
+			const int x1 = min(span[1], from.x + c) - from.x;
+			ei_rect_t dst_rect = get_ei_rect_intersection((ei_rect_t){{where.x + x0, where.y + row}, {x1 - x0, 1}}, clip);
+			if(dst_rect.size.width <= 0 || dst_rect.size.height <= 0)
+				continue;
+			ei_rect_t src_rect = {{from.x + dst_rect.top_left.x - where.x, from.y + row}, dst_rect.size};
+			ei_copy_desc(&dst, &dst_rect, &entry->desc, &src_rect, EI_FALSE);
+		}
+	}
+
+	/* the 4 borders between the corners, and the center (a cross when the corners are rounded) */
+	const struct {
+		ei_rect_t		rect;
+		const ei_color_t*	color;
+	} fills[] = {
+		{{{x + c, y}, {w - 2 * c, border_width}}, &entry->top_color},
+		{{{x, y + c}, {border_width, h - 2 * c}}, &entry->top_color},
+		{{{x + c, y + h - border_width}, {w - 2 * c, border_width}}, &entry->bottom_color},
+		{{{x + w - border_width, y + c}, {border_width, h - 2 * c}}, &entry->bottom_color},
+		{{{x + border_width, y + c}, {w - 2 * border_width, h - 2 * c}}, &entry->color},
+		{{{x + c, y + border_width}, {w - 2 * c, corner_radius}}, &entry->color},
+		{{{x + c, y + h - c}, {w - 2 * c, corner_radius}}, &entry->color}
+	};
+	for(size_t i = 0; i < sizeof(fills) / sizeof(fills[0]); i++) {
+		ei_rect_t fill = get_ei_rect_intersection(fills[i].rect, clip);
+		if(fill.size.width > 0 && fill.size.height > 0)
+			ei_fill(surface, fills[i].color, &fill);
+	}
+	return EI_TRUE;
+}
+
+
+void ei_decoration_cache_free(void) {
+	while(oldest)
+		remove_entry(oldest);
+}
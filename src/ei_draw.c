@@ -9,90 +9,142 @@
 #include "ei_types.h"
 #include "hw_interface.h"
 #include "ei_calculations.h"
+#include "ei_surface.h"
+#include "ei_kernels.h"
+#include "ei_text_cache.h"
+#include "ei_scale.h"
+#include "ei_pool.h"
 
 
-void ei_draw_text(ei_surface_t surface, const ei_point_t* where, const char* text, const ei_font_t font, ei_color_t color, const ei_rect_t* clipper) {
-    /* creating the text surface  and locking it */
-    const ei_surface_t txt_surface = hw_text_create_surface(text, font ? font : ei_default_font, color);
-    hw_surface_lock(txt_surface);
-    ei_rect_t dst_rect = {*where, hw_surface_get_size(txt_surface)};
+/* clips the rectangle of a text of the given size drawn at where, and the rectangle of the text that is drawn */
+static void clip_text(const ei_point_t* where, ei_size_t size, const ei_rect_t* clipper, ei_rect_t* dst_rect, ei_rect_t* src_rect) {
+    *dst_rect = (ei_rect_t){*where, size};
+    *src_rect = (ei_rect_t){{0, 0}, size};
     if(clipper) {
         /* if there is a clipper, then intersecting the clipper with the destination... */
-        dst_rect = get_ei_rect_intersection(dst_rect, *clipper);
+        *dst_rect = get_ei_rect_intersection(*dst_rect, *clipper);
         /* ... and the src is also modified to display only the text that is inside the rect */
-        ei_rect_t src_rect = {{max(0, dst_rect.top_left.x-where->x), max(0, dst_rect.top_left.y-where->y)}, dst_rect.size};
-        /* at last we copy the text surface onto the destination */
-        ei_copy_surface(surface, &dst_rect, txt_surface, &src_rect, EI_TRUE);
-    } else
-        ei_copy_surface(surface, &dst_rect, txt_surface, NULL, EI_TRUE);
+        *src_rect = (ei_rect_t){{max(0, dst_rect->top_left.x-where->x), max(0, dst_rect->top_left.y-where->y)}, dst_rect->size};
+    }
+}
+
+
+void ei_draw_text(ei_surface_t surface, const ei_point_t* where, const char* text, const ei_font_t font, ei_color_t color, const ei_rect_t* clipper) {
+    const ei_font_t txt_font = font ? font : ei_default_font;
+    ei_rect_t dst_rect, src_rect;
+
+    /* the coverage of the glyphs, rendered once for each text and font, is tinted with the color */
+    const ei_text_mask_t* mask = ei_text_cache_get(text, txt_font);
+    if(mask) {
+        clip_text(where, mask->size, clipper, &dst_rect, &src_rect);
+        if(dst_rect.size.width <= 0 || dst_rect.size.height <= 0)
+            return;
+        const ei_surface_desc_t dst = ei_surface_desc(surface);
+        const uint8_t* coverage = mask->coverage + src_rect.top_left.y * mask->pitch + src_rect.top_left.x;
+        uint32_t* dst_ptr = EI_PIXEL_AT(&dst, dst_rect.top_left.x, dst_rect.top_left.y);
+        if(dst.format->premultiplied)
+            ei_kernels()->mask_tint_premul(dst_ptr, dst.pitch, coverage, 1, mask->pitch,
+                                           dst_rect.size.width, dst_rect.size.height, dst.format, color);
+        else
+            ei_kernels()->mask_tint(dst_ptr, dst.pitch, coverage, 1, mask->pitch,
+                                    dst_rect.size.width, dst_rect.size.height, dst.format, color);
+        return;
+    }
+
+    /* texts rendered without alpha channel: creating the text surface and locking it */
+    const ei_surface_t txt_surface = hw_text_create_surface(text, txt_font, color);
+    if(!txt_surface)
+        return;
+    hw_surface_lock(txt_surface);
+    clip_text(where, hw_surface_get_size(txt_surface), clipper, &dst_rect, &src_rect);
+
+    /* at last we copy the text surface onto the destination */
+    ei_copy_surface(surface, &dst_rect, txt_surface, &src_rect, EI_TRUE);
+
     hw_surface_unlock(txt_surface);
     /* we don't need this surface anymore */
-    hw_surface_free(txt_surface);
+    ei_surface_free(txt_surface);
+}
+
+
+void ei_font_free(ei_font_t font) {
+    /* the texts are cached by font address, which may be reused */
+    ei_text_cache_forget_font(font);
+    hw_text_font_free(font);
 }
 
 
 uint32_t ei_map_rgba(ei_surface_t surface, const ei_color_t* color) {
-    /* channels indexs (red, green, blue, alpha)*/
-    int ir, ig, ib, ia;
+    /* channels indexs (red, green, blue, alpha), cached for each surface */
+    const ei_pixel_format_t* f = ei_surface_format(surface);
 
-    /* affects ir, ig, ib, ia to the index of the red, blue, green and alpha channels */
-    hw_surface_get_channel_indices(surface, &ir, &ig, &ib, &ia);
+    /* premultiplied surfaces store the color channels multiplied by the alpha */
+    if(f->premultiplied && f->ia >= 0)
+        return EI_PACK(EI_DIV255(color->red * color->alpha), EI_DIV255(color->green * color->alpha),
+                       EI_DIV255(color->blue * color->alpha), color->alpha, f->ir, f->ig, f->ib, f->ia);
 
-    /* int value of the color */
-    uint32_t int_color = 0;
-    
-    /* the red byte */
-    int_color += ((uint32_t) color->red) << (8 * ir);
-    /* the green byte */
-    int_color += ((uint32_t) color->green) << (8 * ig);
-    /* the blue byte */
-    int_color += ((uint32_t) color->blue) << (8 * ib);
-    /* the alpha byte (if ia is -1, the surface does not handle alpha)*/
-    int_color += (ia == -1) ? 0 : ((uint32_t) color->alpha) << (8 * ia);
-
-    return int_color;
+    /* int value of the color (if ia is -1, the surface does not handle alpha) */
+    return EI_PACK(color->red, color->green, color->blue, color->alpha, f->ir, f->ig, f->ib, f->ia);
 }
 
 
 void ei_fill(ei_surface_t surface, const ei_color_t* color, const ei_rect_t* clipper) {
-    /* gets the rectangle and the size of the surface */
-    ei_rect_t surface_rect = hw_surface_get_rect(surface);
-    ei_size_t surface_size = hw_surface_get_size(surface);
+    /* gets the pixels of the surface */
+    const ei_surface_desc_t desc = ei_surface_desc(surface);
 
     /* int value of the color */
     uint32_t int_color = ei_map_rgba(surface, color); 
 
-    /* pointer to the (0;0) pixel */
-    uint32_t* pixel_ptr = (uint32_t *) hw_surface_get_buffer(surface);
-
     /* case : there is a clipper */
     if(clipper != NULL){
-        /* the rectangle that is actually about to be filled (cut by the clipper) */
-        
         /* points to the top left corner of the rectangle that is about to be filled */
-        pixel_ptr += clipper->top_left.x + (clipper->top_left.y * surface_rect.size.width);
-        
+        uint32_t* pixel_ptr = EI_PIXEL_AT(&desc, clipper->top_left.x, clipper->top_left.y);
+
         /* changes the color of all the pixel within the rectangle */
-        for(int y = 0; y < clipper->size.height; y++){
-            for(int x = 0; x < clipper->size.width; x++)
-                *(pixel_ptr++) = int_color;
-
-            /* skip the pixels of the next line at the left of the rectangle */
-            pixel_ptr += surface_rect.size.width - clipper->size.width;
-        }
-    } else {
-        for(int y = 0; y < surface_size.height; y++) {
-            for(int x = 0; x < surface_size.width; x++)
-                *(pixel_ptr++) = int_color;
-        }
-    }
+        ei_kernels()->fill(pixel_ptr, desc.pitch, clipper->size.width, clipper->size.height, int_color);
+    } else
+        ei_kernels()->fill(desc.pixels, desc.pitch, desc.size.width, desc.size.height, int_color);
 }
 
 
 int ei_copy_surface(ei_surface_t destination, const ei_rect_t* dst_rect, const ei_surface_t source, const ei_rect_t* src_rect, const ei_bool_t alpha) {
-    /* if no dst_rect or src_rect was given, then we take the whole surfaces */
-    const ei_rect_t rect1 = {{0, 0}, hw_surface_get_size(source)};
-    const ei_rect_t rect2 = {{0, 0}, hw_surface_get_size(destination)};
+    /* gets the pixels and the color configuration of the surfaces */
+    const ei_surface_desc_t src = ei_surface_desc(source);
+    const ei_surface_desc_t dst = ei_surface_desc(destination);
+
+    /* uses what is known about the transparent pixels of the source (see ei_surface_set_opacity) */
+    ei_bool_t opaque;
+    ei_rect_t visible;
+    if(alpha && ei_surface_get_opacity(source, &opaque, &visible)) {
+        const ei_rect_t rect1 = {{0, 0}, src.size};
+        const ei_rect_t rect2 = {{0, 0}, dst.size};
+        if(!src_rect)
+            src_rect = &rect1;
+        if(!dst_rect)
+            dst_rect = &rect2;
+        if(dst_rect->size.width!=src_rect->size.width || dst_rect->size.height!=src_rect->size.height)
+            return 1;
+
+        /* nothing to blend: the pixels are copied */
+        if(opaque)
+            return ei_copy_desc(&dst, dst_rect, &src, src_rect, EI_FALSE);
+
+        /* the fully transparent borders of the source are skipped */
+        const ei_rect_t src_visible = get_ei_rect_intersection(*src_rect, visible);
+        if(src_visible.size.width <= 0 || src_visible.size.height <= 0)
+            return 0;
+        const ei_rect_t dst_visible = {{dst_rect->top_left.x + src_visible.top_left.x - src_rect->top_left.x,
+                                        dst_rect->top_left.y + src_visible.top_left.y - src_rect->top_left.y}, src_visible.size};
+        return ei_copy_desc(&dst, &dst_visible, &src, &src_visible, EI_TRUE);
+    }
+    return ei_copy_desc(&dst, dst_rect, &src, src_rect, alpha);
+}
+
+
+int ei_copy_desc(const ei_surface_desc_t* dst, const ei_rect_t* dst_rect, const ei_surface_desc_t* src, const ei_rect_t* src_rect, const ei_bool_t alpha) {
+    /* if no dst_rect or src_rect was given, then we take the whole descriptors */
+    const ei_rect_t rect1 = {{0, 0}, src->size};
+    const ei_rect_t rect2 = {{0, 0}, dst->size};
     if(!src_rect)
         src_rect = &rect1;
     if(!dst_rect)
@@ -100,46 +152,65 @@ int ei_copy_surface(ei_surface_t destination, const ei_rect_t* dst_rect, const e
     if(dst_rect->size.width!=src_rect->size.width || dst_rect->size.height!=src_rect->size.height)
         return 1;
 
-    /* gets the color configuration of the destination surface */
-    int dir;
-    int dig;
-    int dib;
-    int dia;
-    hw_surface_get_channel_indices(destination, &dir, &dig, &dib, &dia);
-    /* gets the color configuration of the source surface */
-    int sir;
-    int sig;
-    int sib;
-    int sia;
-    hw_surface_get_channel_indices(source, &sir, &sig, &sib, &sia);
-
-    ei_size_t src_size = hw_surface_get_size(source);
-    ei_size_t dst_size = hw_surface_get_size(destination);
-    /* pointer to the (0;0) pixel */
-    uint32_t* src_ptr = (uint32_t *) hw_surface_get_buffer(source);
-    uint32_t* dst_ptr = (uint32_t *) hw_surface_get_buffer(destination);
-    src_ptr += src_rect->top_left.x + (src_rect->top_left.y * src_size.width);
-    dst_ptr += dst_rect->top_left.x + (dst_rect->top_left.y * dst_size.width);
-
-    /* copying from src_ptr to dst_ptr */
-    for(int y = 0; y < src_rect->size.height; y++) {
-        for(int x = 0; x < src_rect->size.width; x++) {
-            /* decomposing the color at *src_ptr */
-            ei_color_t src_color = {(*src_ptr>>(8*sir))&0xff, (*src_ptr>>(8*sig))&0xff, (*src_ptr>>(8*sib))&0xff, (*src_ptr>>(8*sia))&0xff};
-            if(alpha) {
-                /* if we need alpha, we compute a weighted mean (by the alpha canal of the source pixel) between the source pixel and the destination pixel */
-                float cnl = ((float)src_color.alpha)/256;
-                ei_color_t dst_color = {(*dst_ptr>>(8*dir))&0xff, (*dst_ptr>>(8*dig))&0xff, (*dst_ptr>>(8*dib))&0xff, (*dst_ptr>>(8*dia))&0xff};
-                const ei_color_t color = {src_color.red*cnl+dst_color.red*(1-cnl), src_color.green*cnl+dst_color.green*(1-cnl), src_color.blue*cnl+dst_color.blue*(1-cnl), 255};
-                *dst_ptr = ei_map_rgba(destination, &color);
-            } else
-                *dst_ptr = ei_map_rgba(destination, &src_color);
-            dst_ptr++;
-            src_ptr++;
-        }
-        /* jumping one pixel below */
-        dst_ptr += dst_size.width - src_rect->size.width;
-        src_ptr += src_size.width - src_rect->size.width;
+    const ei_pixel_format_t* df = dst->format;
+    const ei_pixel_format_t* sf = src->format;
+    /* pointers to the top left pixels of the rectangles */
+    const uint32_t* src_ptr = EI_PIXEL_AT(src, src_rect->top_left.x, src_rect->top_left.y);
+    uint32_t* dst_ptr = EI_PIXEL_AT(dst, dst_rect->top_left.x, dst_rect->top_left.y);
+    const int width = src_rect->size.width;
+    const int height = src_rect->size.height;
+
+    /* the kernel is chosen once for the whole copy */
+    const ei_kernels_t* kernels = ei_kernels();
+    if(alpha && (sf->premultiplied || df->premultiplied))
+        /* premultiplied pipeline: one multiply-add per channel, the alpha channels are composed */
+        kernels->blend_premul(dst_ptr, dst->pitch, src_ptr, src->pitch, width, height, df, sf, sf->premultiplied);
+    else if(alpha)
+        kernels->blend(dst_ptr, dst->pitch, src_ptr, src->pitch, width, height, df, sf);
+    else if(sf->order == df->order && sf->order != ei_pixel_order_other)
+        /* same format, no alpha: the pixels are copied as is */
+        kernels->copy(dst_ptr, dst->pitch, src_ptr, src->pitch, width, height);
+    else
+        kernels->swizzle(dst_ptr, dst->pitch, src_ptr, src->pitch, width, height, df, sf);
+    return 0;
+}
+
+
+int ei_copy_surface_scaled(ei_surface_t destination, const ei_rect_t* dst_rect, const ei_surface_t source, const ei_rect_t* src_rect, const ei_bool_t alpha, ei_filter_t filter, const ei_rect_t* clipper) {
+    const ei_surface_desc_t src = ei_surface_desc(source);
+    const ei_surface_desc_t dst = ei_surface_desc(destination);
+    const ei_rect_t rect1 = {{0, 0}, src.size};
+    const ei_rect_t rect2 = {{0, 0}, dst.size};
+    if(!src_rect)
+        src_rect = &rect1;
+    if(!dst_rect)
+        dst_rect = &rect2;
+    if(src_rect->size.width <= 0 || src_rect->size.height <= 0)
+        return 1;
+
+    /* the part of the destination which is drawn */
+    ei_rect_t clip = get_ei_rect_intersection(*dst_rect, rect2);
+    if(clipper)
+        clip = get_ei_rect_intersection(clip, *clipper);
+    if(clip.size.width <= 0 || clip.size.height <= 0)
+        return 0;
+
+    /* same format, no alpha: the source is scaled in place */
+    if(!alpha && src.format->order == dst.format->order && src.format->order != ei_pixel_order_other) {
+        ei_scale_desc(&dst, dst_rect, &src, src_rect, filter, &clip);
+        return 0;
     }
+
+    /* else the drawn part is scaled in a temporary buffer, then copied (or blended) */
+    ei_surface_desc_t tmp;
+    tmp.pixels = ei_pool_get(clip.size.width, clip.size.height, 4, &tmp.pitch);
+    if(!tmp.pixels)
+        return 1;
+    tmp.size = clip.size;
+    tmp.format = src.format;
+    const ei_rect_t tmp_rect = {{dst_rect->top_left.x - clip.top_left.x, dst_rect->top_left.y - clip.top_left.y}, dst_rect->size};
+    ei_scale_desc(&tmp, &tmp_rect, &src, src_rect, filter, NULL);
+    ei_copy_desc(&dst, &clip, &tmp, NULL, alpha);
+    ei_pool_put(tmp.pixels);
     return 0;
 }
@@ -13,6 +13,7 @@
 #include "ei_buttonclass.h"
 #include "ei_toplevelclass.h"
 #include "ei_calculations.h"
+#include "ei_decoration.h"
 
 extern ei_button_t *button_pressed;
 extern ei_bool_t pressing_over;
@@ -233,6 +234,50 @@ ei_linked_point_t* ei_rounded_frame_all(ei_rect_t rect, int r){
     return top_left_arc;
 }
 
+ei_rect_t ei_text_rect(const char* text, ei_font_t font, ei_anchor_t anchor, ei_rect_t content) {
+    ei_point_t where = content.top_left;
+    /* computing text width and text height */
+    int tw; int th;
+    hw_text_compute_size(text, font, &tw, &th);
+    /* getting surface position and dimension */
+    const int sw = content.size.width;
+    const int sh = content.size.height;
+    const int sx = content.top_left.x;
+    const int sy = content.top_left.y;
+    /* Computing text location */
+    switch(anchor) {
+        case ei_anc_none:
+        case ei_anc_center:
+            where = (ei_point_t){sx+(sw-tw)/2, sy+(sh-th)/2};
+            break;
+        case ei_anc_north:
+            where = (ei_point_t){sx+(sw-tw)/2, sy};
+            break;
+        case ei_anc_northeast:
+            where = (ei_point_t){sx+sw-tw, sy};
+            break;
+        case ei_anc_east:
+            where = (ei_point_t){sx+sw-tw, sy+(sh-th)/2};
+            break;
+        case ei_anc_southeast:
+            where = (ei_point_t){sx+sw-tw, sy+sh-th};
+            break;
+        case ei_anc_south:
+            where = (ei_point_t){sx+(sw-tw)/2, sy+sh-th};
+            break;
+        case ei_anc_southwest:
+            where = (ei_point_t){sx, sy+sh-th};
+            break;
+        case ei_anc_west:
+            where = (ei_point_t){sx, sy+(sh-th)/2};
+            break;
+        case ei_anc_northwest:
+            where = (ei_point_t){sx, sy};
+            break;
+    }
+    return (ei_rect_t){where, {tw, th}};
+}
+
 void drawframebuttonclasses(struct ei_widget_t*     widget,
                       ei_surface_t      surface,
                       ei_surface_t      pick_surface,
@@ -248,37 +293,34 @@ void drawframebuttonclasses(struct ei_widget_t*     widget,
     ei_font_t *text_font;
     ei_color_t *text_color;
     ei_anchor_t *text_anchor;
-    ei_surface_t *img;
-    ei_rect_t *img_rect;
+    ei_surface_view_t *img;
     ei_anchor_t *img_anchor;
+    ei_image_scaling_t *img_scaling;
     int corner_radius = 0;
     ei_bool_t no_clipping = EI_FALSE;
     if(isFrame) { /* Case 1: it is a frame */
-        border_width = widget_frame->border_width;
-        color = widget_frame->color;
-        relief = widget_frame->relief;
-        text = widget_frame->text;
-        text_font = widget_frame->text_font;
-        text_color = widget_frame->text_color;
-        text_anchor = widget_frame->text_anchor;
-        img = widget_frame->img;
-        img_rect = widget_frame->img_rect;
-        img_anchor = widget_frame->img_anchor;
+        border_width = &widget_frame->border_width;
+        color = &widget_frame->color;
+        relief = &widget_frame->relief;
+        text = (widget_frame->set & ei_attr_text) ? &widget_frame->text : NULL;
+        text_font = &widget_frame->text_font;
+        text_color = &widget_frame->text_color;
+        text_anchor = &widget_frame->text_anchor;
+        img = (widget_frame->set & ei_attr_img) ? &widget_frame->img : NULL;
+        img_anchor = &widget_frame->img_anchor;
+        img_scaling = (widget_frame->set & ei_attr_img_scaling) ? &widget_frame->img_scaling : NULL;
     } else { /* Case 2: it is a button */
-        border_width = widget_button->border_width;
-        color = widget_button->color;
-        relief = widget_button->relief;
-        text = widget_button->text;
-        text_font = widget_button->text_font;
-        text_anchor = widget_button->text_anchor;
-        text_color = widget_button->text_color;
-        img = widget_button->img;
-        img_rect = widget_button->img_rect;
-        img_anchor = widget_button->img_anchor;
-        if(widget_button->corner_radius)
-            corner_radius = *widget_button->corner_radius;
-        else
-            corner_radius = k_default_button_corner_radius;
+        border_width = &widget_button->border_width;
+        color = &widget_button->color;
+        relief = &widget_button->relief;
+        text = (widget_button->set & ei_attr_text) ? &widget_button->text : NULL;
+        text_font = &widget_button->text_font;
+        text_anchor = &widget_button->text_anchor;
+        text_color = &widget_button->text_color;
+        img = (widget_button->set & ei_attr_img) ? &widget_button->img : NULL;
+        img_anchor = &widget_button->img_anchor;
+        img_scaling = (widget_button->set & ei_attr_img_scaling) ? &widget_button->img_scaling : NULL;
+        corner_radius = widget_button->corner_radius;
         no_clipping = widget_button->no_clipping;
     }
     ei_rect_t final_clipper = widget->screen_location;
@@ -295,99 +337,64 @@ void drawframebuttonclasses(struct ei_widget_t*     widget,
 
         ei_color_t top_color;
         ei_color_t bottom_color;
-        switch(*relief) {
-            case ei_relief_none:
-                top_color = darken_color(*color);
-                bottom_color = darken_color(*color);
-                break;
-            case ei_relief_raised:
-                top_color = lighten_color(*color);
-                bottom_color = darken_color(*color);
-                break;
-            case ei_relief_sunken:
-                top_color = darken_color(*color);
-                bottom_color = lighten_color(*color);
-                break;
+        ei_relief_colors(*color, *relief, &top_color, &bottom_color);
+        /* Drawing the very widget: from the cached corners, or with polygons if it can't be */
+        if(no_clipping || !ei_decoration_draw(surface, widget->screen_location, corner_radius, *border_width,
+                                              *relief, *color, border_clipper)) {
+            ei_linked_point_t *high = ei_rounded_frame_high(widget->screen_location, corner_radius);
+            ei_linked_point_t *low = ei_rounded_frame_low(widget->screen_location, corner_radius);
+            ei_linked_point_t *all = ei_rounded_frame_all(final_clipper, corner_radius);
+            ei_draw_polygon(surface, high, top_color, border_clipper);
+            ei_draw_polygon(surface, low, bottom_color, border_clipper);
+            ei_draw_polygon(surface, all, *color, &final_clipper);
+            /* Freeing the points allocated by the rounded_frame functions (for memory's sake) */
+            ei_free_linked_points_list(high);
+            ei_free_linked_points_list(low);
+            ei_free_linked_points_list(all);
         }
-        /* Drawing the very widget */
-        ei_linked_point_t *high = ei_rounded_frame_high(widget->screen_location, corner_radius);
-        ei_linked_point_t *low = ei_rounded_frame_low(widget->screen_location, corner_radius);
-        ei_linked_point_t *all = ei_rounded_frame_all(final_clipper, corner_radius);
-        ei_draw_polygon(surface, high, top_color, border_clipper);
-        ei_draw_polygon(surface, low, bottom_color, border_clipper);
-        ei_draw_polygon(surface, all, *color, &final_clipper);
-        /* Freeing the points allocated by the rounded_frame functions (for memory's sake) */
-        ei_free_linked_points_list(high);
-        ei_free_linked_points_list(low);
-        ei_free_linked_points_list(all);
     } else {
         ei_linked_point_t *all = ei_rounded_frame_all(widget->screen_location, 0);
         ei_draw_polygon(surface, all, *color, border_clipper);
         ei_free_linked_points_list(all);
     }
-    /* filling the pick_surface with the widget's pick_color */
-    ei_linked_point_t *pick_pts = ei_rounded_frame_all(widget->screen_location, corner_radius);
-    ei_draw_polygon(pick_surface, pick_pts, *widget->pick_color, border_clipper);
-    ei_free_linked_points_list(pick_pts);
+    /* filling the pick_surface with the widget's pick_color (only in the offscreen picking mode) */
+    if(pick_surface) {
+        ei_linked_point_t *pick_pts = ei_rounded_frame_all(widget->screen_location, corner_radius);
+        ei_draw_polygon(pick_surface, pick_pts, widget->pick_color, border_clipper);
+        ei_free_linked_points_list(pick_pts);
+    }
 
     if(text) {
-        ei_point_t where;
-        /* computing text width and text height */
-        int tw; int th;
-        hw_text_compute_size(*text, *text_font, &tw, &th);
-        /* getting surface position and dimension */
-        const int sw = widget->content_rect->size.width;
-        const int sh = widget->content_rect->size.height;
-        const int sx = widget->content_rect->top_left.x;
-        const int sy = widget->content_rect->top_left.y;
-        /* Computing text location */
-        switch(*text_anchor) {
-            case ei_anc_none:
-            case ei_anc_center:
-                where = (ei_point_t){sx+(sw-tw)/2, sy+(sh-th)/2};
-                break;
-            case ei_anc_north:
-                where = (ei_point_t){sx+(sw-tw)/2, sy};
-                break;
-            case ei_anc_northeast:
-                where = (ei_point_t){sx+sw-tw, sy};
-                break;
-            case ei_anc_east:
-                where = (ei_point_t){sx+sw-tw, sy+(sh-th)/2};
-                break;
-            case ei_anc_southeast:
-                where = (ei_point_t){sx+sw-tw, sy+sh-th};
-                break;
-            case ei_anc_south:
-                where = (ei_point_t){sx+(sw-tw)/2, sy+sh-th};
-                break;
-            case ei_anc_southwest:
-                where = (ei_point_t){sx, sy+sh-th};
-                break;
-            case ei_anc_west:
-                where = (ei_point_t){sx, sy+(sh-th)/2};
-                break;
-            case ei_anc_northwest:
-                where = (ei_point_t){sx, sy};
-                break;
-        }
+        ei_point_t where = ei_text_rect(*text, *text_font, *text_anchor, *widget->content_rect).top_left;
         if((ei_widget_t*)button_pressed == widget && pressing_over) {
-            where.x += *widget_button->border_width*0.65;
-            where.y += *widget_button->border_width*0.65;
+            where.x += widget_button->border_width*0.65;
+            where.y += widget_button->border_width*0.65;
         }
         ei_draw_text(surface, &where, *text, *text_font, *text_color, &final_clipper);
+    } else if(img && img_scaling) {
+        /* the image fills the content: it is scaled once for each size of the content */
+        ei_rect_t where = *widget->content_rect;
+        if((ei_widget_t*)button_pressed == widget && pressing_over) {
+            where.top_left.x += widget_button->border_width*0.65;
+            where.top_left.y += widget_button->border_width*0.65;
+        }
+        hw_surface_lock(img->surface);
+        const ei_surface_desc_t *scaled = ei_scale_cache_get(img, where.size, img_scaling);
+        if(scaled) {
+            const ei_surface_desc_t dst = ei_surface_desc(surface);
+            ei_rect_t dst_rect = get_ei_rect_intersection(where, final_clipper);
+            dst_rect = get_ei_rect_intersection(dst_rect, (ei_rect_t){{0, 0}, dst.size});
+            ei_rect_t src_rect = (ei_rect_t){{dst_rect.top_left.x - where.top_left.x,
+                                              dst_rect.top_left.y - where.top_left.y}, dst_rect.size};
+            if(dst_rect.size.width > 0 && dst_rect.size.height > 0)
+                ei_copy_desc(&dst, &dst_rect, scaled, &src_rect, EI_FALSE);
+        }
+        hw_surface_unlock(img->surface);
     } else if(img) {
         ei_point_t where;
         /* getting image width and text height */
-        int iw; int ih;
-        if(img_rect) {
-            iw = img_rect->size.width;
-            ih = img_rect->size.height;
-        } else {
-            ei_size_t s_size = hw_surface_get_size(*img);
-            iw = s_size.width;
-            ih = s_size.height;
-        }
+        const int iw = img->rect.size.width;
+        const int ih = img->rect.size.height;
         /* getting surface position and dimension */
         const int sw = widget->content_rect->size.width;
         const int sh = widget->content_rect->size.height;
@@ -424,23 +431,38 @@ void drawframebuttonclasses(struct ei_widget_t*     widget,
                 break;
         }
         if((ei_widget_t*)button_pressed == widget && pressing_over) {
-            where.x += *widget_button->border_width*0.65;
-            where.y += *widget_button->border_width*0.65;
+            where.x += widget_button->border_width*0.65;
+            where.y += widget_button->border_width*0.65;
         }
-        hw_surface_lock(*img);
+        hw_surface_lock(img->surface);
         ei_rect_t dst_rect = (ei_rect_t){where, (ei_size_t){iw, ih}};
         dst_rect = get_ei_rect_intersection(dst_rect, final_clipper);
-        ei_rect_t src_rect;
-        if(img_rect)
-            src_rect = (ei_rect_t){img_rect->top_left, dst_rect.size};
-        else
-            src_rect = (ei_rect_t){{0, 0}, dst_rect.size};
-        ei_copy_surface(surface, &dst_rect, *img, &src_rect, EI_FALSE);
-        hw_surface_unlock(*img);
+        /* the part of the view which is not clipped */
+        ei_rect_t src_rect = (ei_rect_t){{img->rect.top_left.x + dst_rect.top_left.x - where.x,
+                                          img->rect.top_left.y + dst_rect.top_left.y - where.y}, dst_rect.size};
+        ei_copy_surface(surface, &dst_rect, img->surface, &src_rect, EI_FALSE);
+        hw_surface_unlock(img->surface);
     }
 }
 
 
+void ei_relief_colors(ei_color_t color, ei_relief_t relief, ei_color_t* top_color, ei_color_t* bottom_color) {
+    switch(relief) {
+        case ei_relief_none:
+            *top_color = darken_color(color);
+            *bottom_color = darken_color(color);
+            break;
+        case ei_relief_raised:
+            *top_color = lighten_color(color);
+            *bottom_color = darken_color(color);
+            break;
+        case ei_relief_sunken:
+            *top_color = darken_color(color);
+            *bottom_color = lighten_color(color);
+            break;
+    }
+}
+
 ei_color_t darken_color(ei_color_t color) {
     ei_color_t new_color = {color.red*0.8, color.green*0.8, color.blue*0.8, color.alpha};
     return new_color;
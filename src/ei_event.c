@@ -81,25 +81,43 @@ ei_linked_binded_event *get_top_event_bind() {
     return top_event_bind;
 }
 
-void destroy_event_binded_to_widget(ei_widget_t * widget) {
+/* true if widget is root or one of its descendants */
+static ei_bool_t in_subtree(ei_widget_t * widget, ei_widget_t * root) {
+    for(; widget; widget = widget->parent)
+        if(widget == root)
+            return EI_TRUE;
+    return EI_FALSE;
+}
+
+void destroy_event_binded_to_subtree(ei_widget_t * root) {
+    /* one pass over the bindings: the ones of the destroyed widgets are only disabled, since
+       the event loop may be walking the list (a callback can destroy its own widget) */
+    for(ei_linked_binded_event * curr_bind = top_event_bind; curr_bind; curr_bind = curr_bind->next) {
+        if(curr_bind->widget && in_subtree(curr_bind->widget, root)) {
+            curr_bind->widget = NULL;
+            curr_bind->eventtype = ei_ev_none;
+        }
+    }
+}
+
+void ei_event_sweep(void) {
     ei_linked_binded_event * last_bind = NULL;
-    ei_linked_binded_event * curr_bind = get_top_event_bind();
+    ei_linked_binded_event * curr_bind = top_event_bind;
     ei_linked_binded_event * next_bind;
-    
+
     while(curr_bind){
         next_bind = curr_bind->next;
 
-        if(curr_bind->widget == widget){
-            if(!last_bind){
-                top_event_bind = curr_bind->next;
-            } else {
-                last_bind->next = curr_bind->next;
-            }
-
+        /* a disabled binding has neither widget nor tag */
+        if(!curr_bind->widget && !curr_bind->tag){
+            if(!last_bind)
+                top_event_bind = next_bind;
+            else
+                last_bind->next = next_bind;
             free(curr_bind);
-        }
+        } else
+            last_bind = curr_bind;
 
-        last_bind = curr_bind;
         curr_bind = next_bind;
     }
 }
@@ -21,34 +21,10 @@ void* allocframe(void) {
 void releaseframe(struct ei_widget_t* widget) {
 	ei_frame_t* widget_frame = (ei_frame_t *)widget;
 	
-	/* Frees the memory of the general attributes */
+	/* The attributes are stored in the frame: only the image is shared */
 	/* The widget itself is *not* destroyed by this function */
-	if(widget_frame->border_width)
-		free(widget_frame->border_width);
-	if(widget_frame->relief)
-		free(widget_frame->relief);
-	if(widget_frame->relief)
-		free(widget_frame->color);
-	if(widget->content_rect && widget->content_rect != &widget->screen_location)
-		free(widget->content_rect);
-
-	/* Frees text related stuffs */
-	if(widget_frame->text)
-		free(widget_frame->text);
-	if(widget_frame->text_font)
-		free(widget_frame->text_font);
-	if(widget_frame->text_color)
-		free(widget_frame->text_color);
-	if(widget_frame->text_anchor)
-		free(widget_frame->text_anchor);
-
-	/* Frees img related stuffs */
-	if(widget_frame->img)
-		free(widget_frame->img);
-	if(widget_frame->img_rect)
-		free(widget_frame->img_rect);
-	if(widget_frame->img_anchor)
-		free(widget_frame->img_anchor);
+	if(widget_frame->set & ei_attr_img)
+		ei_surface_view_release(&widget_frame->img);
 }
 
 void drawframe(struct ei_widget_t*		widget,
@@ -64,77 +40,48 @@ void setdefaultsframe(struct ei_widget_t* widget) {
 	widget_frame = (ei_frame_t *)widget;
 
 	/* configures the default color, relief and border width */
-	if(widget_frame->color == NULL)
-		widget_frame->color = malloc(sizeof(ei_color_t));
-	*(widget_frame->color) = ei_default_background_color;
-
-	if(widget_frame->relief == NULL)
-		widget_frame->relief = malloc(sizeof(ei_relief_t));
-	*(widget_frame->relief) = ei_relief_none;
-
-	if(widget_frame->border_width == NULL)
-		widget_frame->border_width = malloc(sizeof(int));
-	*(widget_frame->border_width) = 0;
+	widget_frame->color = ei_default_background_color;
+	widget_frame->relief = ei_relief_none;
+	widget_frame->border_width = 0;
 	widget->content_rect = &widget->screen_location;
 
 	/**  
 	 * configures the default text attributes
-	 * even if the default text pointer is NULL, the text font, color and anchor
+	 * even if the frame has no text, the text font, color and anchor
 	 * are initialised so that they do not have to be defined later
 	 */
-	widget_frame->text = NULL;
-
-	if(widget_frame->text_font == NULL)
-		widget_frame->text_font = malloc(sizeof(ei_font_t));
-	*(widget_frame->text_font) = ei_default_font;
-
-	if(widget_frame->text_color == NULL)
-		widget_frame->text_color = malloc(sizeof(ei_color_t));
-	*(widget_frame->text_color) = ei_font_default_color;
-
-	if(widget_frame->text_anchor == NULL)
-		widget_frame->text_anchor = malloc(sizeof(ei_anchor_t));
-	*(widget_frame->text_anchor) = ei_anc_center;
+	widget_frame->text_font = ei_default_font;
+	widget_frame->text_color = ei_font_default_color;
+	widget_frame->text_anchor = ei_anc_center;
 
 	/**  
 	 * configures the default image attributes
-	 * even if the default image pointer is NULL, the image anchor
+	 * even if the frame has no image, the image anchor
 	 * is initialised so that it does not have to be defined later 
 	 */
-	if(widget_frame->img)
-		free(widget_frame->img);
-	widget_frame->img = NULL;
-	if(widget_frame->img_rect)
-		free(widget_frame->img_rect);
-	widget_frame->img_rect = NULL;
+	if(widget_frame->set & ei_attr_img)
+		ei_surface_view_release(&widget_frame->img);
+	widget_frame->img_anchor = ei_anc_center;
 
-	if(widget_frame->img_anchor == NULL)
-		widget_frame->img_anchor = malloc(sizeof(ei_anchor_t));
-	*(widget_frame->img_anchor) = ei_anc_center;
+	/* no text, no image, natural size */
+	widget_frame->set = 0;
 }
 
 void geomnotifyframe(struct ei_widget_t* widget) {
-	int *border_width = ((ei_frame_t*)widget)->border_width;
-	ei_rect_t old_rect = *widget->content_rect;
-	if(border_width && *border_width) {
-		if(widget->content_rect == &(widget->screen_location))
-	        widget->content_rect = malloc(sizeof(ei_rect_t));
+	const int border_width = ((ei_frame_t*)widget)->border_width;
+	if(border_width) {
+		widget->content_rect = &widget->inner_rect;
 	    *widget->content_rect = (ei_rect_t){
 	        {
-	            widget->screen_location.top_left.x+(*border_width),
-	            widget->screen_location.top_left.y+(*border_width)
+	            widget->screen_location.top_left.x+border_width,
+	            widget->screen_location.top_left.y+border_width
 	        },
 	        {
-	            widget->screen_location.size.width-2*(*border_width),
-	            widget->screen_location.size.height-2*(*border_width)
+	            widget->screen_location.size.width-2*border_width,
+	            widget->screen_location.size.height-2*border_width
 	        }
 	    };
 	}
-	ei_widget_t *sibling = widget->children_head;
-	while(sibling) {
-		if(sibling->geom_params)
-			sibling->geom_params->manager->runfunc(sibling);
-		sibling = sibling->next_sibling;
-	}
+	ei_geometrymanager_run_children(widget);
 	ei_app_invalidate_rect(&widget->screen_location);
 }
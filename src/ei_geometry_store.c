@@ -0,0 +1,124 @@
+/**
+ *  @file	ei_geometry_store.c
+ *  @brief	Copy of the geometry of the widgets in parallel arrays (their rectangles and the
+ *		hierarchy), indexed by the pick ids of the widgets: the traversals that only
+ *		need the geometry (culling, hit testing) stream over contiguous memory instead of
+ *		following the pointers of the widgets.
+ *
+ */
+
+#include "ei_geometry_store.h"
+#include "ei_buttonclass.h"
+#include "ei_toplevelclass.h"
+#include "ei_utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static ei_geometry_store_t store = {0};
+
+
+const ei_geometry_store_t* ei_geometry_store(void) {
+	return &store;
+}
+
+
+static void reset_slot(uint32_t slot) {
+	store.screen[slot] = ei_rect_zero();
+	store.content[slot] = ei_rect_zero();
+	store.bounds[slot] = ei_rect_zero();
+	store.parent[slot] = EI_GEOMETRY_NONE;
+	store.first_child[slot] = EI_GEOMETRY_NONE;
+	store.last_child[slot] = EI_GEOMETRY_NONE;
+	store.next_sibling[slot] = EI_GEOMETRY_NONE;
+	store.flags[slot] = 0;
+}
+
+
+void ei_geometry_store_add(ei_widget_t* widget) {
+	/* the pick ids are reused, so the arrays stay as big as the most widgets alive at once */
+	if(widget->pick_id >= store.size) {
+		uint32_t size = store.size ? store.size : 64;
+		while(size <= widget->pick_id)
+			size *= 2;
+		store.screen = realloc(store.screen, size * sizeof(ei_rect_t));
+		store.content = realloc(store.content, size * sizeof(ei_rect_t));
+		store.bounds = realloc(store.bounds, size * sizeof(ei_rect_t));
+		store.parent = realloc(store.parent, size * sizeof(int32_t));
+		store.first_child = realloc(store.first_child, size * sizeof(int32_t));
+		store.last_child = realloc(store.last_child, size * sizeof(int32_t));
+		store.next_sibling = realloc(store.next_sibling, size * sizeof(int32_t));
+		store.flags = realloc(store.flags, size * sizeof(uint8_t));
+		for(uint32_t slot = store.size; slot < size; slot++)
+			reset_slot(slot);
+		store.size = size;
+	}
+	reset_slot(widget->pick_id);
+}
+
+
+void ei_geometry_store_link(ei_widget_t* widget, ei_widget_t* previous) {
+	const int32_t slot = (int32_t)widget->pick_id;
+	const int32_t parent = (int32_t)widget->parent->pick_id;
+	store.parent[slot] = parent;
+	if(previous) {
+		store.next_sibling[slot] = store.next_sibling[previous->pick_id];
+		store.next_sibling[previous->pick_id] = slot;
+	} else {
+		store.next_sibling[slot] = store.first_child[parent];
+		store.first_child[parent] = slot;
+	}
+	if(store.next_sibling[slot] == EI_GEOMETRY_NONE)
+		store.last_child[parent] = slot;
+}
+
+
+void ei_geometry_store_unlink(ei_widget_t* widget, ei_widget_t* previous) {
+	const int32_t slot = (int32_t)widget->pick_id;
+	const int32_t parent = store.parent[slot];
+	if(parent == EI_GEOMETRY_NONE)
+		return;
+	if(previous)
+		store.next_sibling[previous->pick_id] = store.next_sibling[slot];
+	else
+		store.first_child[parent] = store.next_sibling[slot];
+	if(store.last_child[parent] == slot)
+		store.last_child[parent] = previous ? (int32_t)previous->pick_id : EI_GEOMETRY_NONE;
+	store.parent[slot] = EI_GEOMETRY_NONE;
+	store.next_sibling[slot] = EI_GEOMETRY_NONE;
+}
+
+
+void ei_geometry_store_update(ei_widget_t* widget) {
+	const uint32_t slot = widget->pick_id;
+	store.screen[slot] = widget->screen_location;
+	store.content[slot] = *widget->content_rect;
+	store.bounds[slot] = strcmp(widget->wclass->name, "toplevel") ?
+			     widget->screen_location : ((ei_toplevel_t*)widget)->draw_rect;
+
+	uint8_t flags = widget->geom_params ? ei_geometry_mapped : 0;
+	if(!strcmp(widget->wclass->name, "button") && ((ei_button_t*)widget)->no_clipping)
+		flags |= ei_geometry_unclipped;
+	if(widget->hidden)
+		flags |= ei_geometry_hidden;
+	store.flags[slot] = flags;
+}
+
+
+void ei_geometry_store_remove(ei_widget_t* widget) {
+	if(widget->pick_id < store.size)
+		reset_slot(widget->pick_id);
+}
+
+
+void ei_geometry_store_free(void) {
+	free(store.screen);
+	free(store.content);
+	free(store.bounds);
+	free(store.parent);
+	free(store.first_child);
+	free(store.last_child);
+	free(store.next_sibling);
+	free(store.flags);
+	memset(&store, 0, sizeof(store));
+}
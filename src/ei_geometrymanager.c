@@ -9,6 +9,8 @@
 #include "ei_application.h"
 #include "ei_utils.h"
 #include "ei_widget.h"
+#include "ei_geometry_store.h"
+#include "ei_toplevelclass.h"
 
 /* top of the list of the geomtry managers */
 ei_geometrymanager_t *geommanager_top = NULL;
@@ -41,7 +43,7 @@ ei_geometrymanager_t* ei_geometrymanager_from_name(ei_geometrymanager_name_t nam
 	return current_gm;
 }
 
-void ei_geometrymanager_unmap(ei_widget_t* widget) {
+void ei_geometrymanager_release(ei_widget_t* widget) {
 	/* returns silent if the widget has no geometrical parameters */
 	if(!widget->geom_params)
 		return;
@@ -53,7 +55,14 @@ void ei_geometrymanager_unmap(ei_widget_t* widget) {
 	/* frees its geometrical parameters and set them to NULL */
 	free(widget->geom_params);
 	widget->geom_params = NULL;
+}
+
+void ei_geometrymanager_unmap(ei_widget_t* widget) {
+	/* returns silent if the widget has no geometrical parameters */
+	if(!widget->geom_params)
+		return;
 
+	ei_geometrymanager_release(widget);
 
 	/**
 	 * the screen needs to be updated when the widget is removed,
@@ -63,6 +72,57 @@ void ei_geometrymanager_unmap(ei_widget_t* widget) {
 	
 	/* sets a default location */
 	widget->screen_location = ei_rect_zero();
+	ei_geometry_store_update(widget);
+}
+
+void ei_geometrymanager_resolve(ei_widget_t* widget) {
+	ei_widget_t *parent = widget->parent;
+	if(!parent || !widget->geom_params)
+		return;
+	ei_geometrymanager_resolve(parent);
+	if(widget->parent_version == parent->geom_version)
+		return;
+
+	/* the content of the parent was resized: the geometry is computed again */
+	const ei_rect_t content = *parent->content_rect;
+	if(content.size.width != widget->parent_size.width || content.size.height != widget->parent_size.height) {
+		widget->geom_params->manager->runfunc(widget);
+		widget->parent_version = parent->geom_version;
+		return;
+	}
+
+	/* it only moved: so do the rectangles of the widget */
+	widget->parent_version = parent->geom_version;
+	const int dx = content.top_left.x + widget->relative_position.x - widget->screen_location.top_left.x;
+	const int dy = content.top_left.y + widget->relative_position.y - widget->screen_location.top_left.y;
+	if(!dx && !dy)
+		return;
+	widget->screen_location.top_left.x += dx;
+	widget->screen_location.top_left.y += dy;
+	widget->inner_rect.top_left.x += dx;
+	widget->inner_rect.top_left.y += dy;
+	if(!strcmp(widget->wclass->name, "toplevel")) {
+		((ei_toplevel_t*)widget)->draw_rect.top_left.x += dx;
+		((ei_toplevel_t*)widget)->draw_rect.top_left.y += dy;
+	}
+	widget->geom_version++;
+	ei_geometry_store_update(widget);
+}
+
+void ei_geometrymanager_run_children(ei_widget_t* widget) {
+	/* the children are placed relatively to the content, which may have moved */
+	widget->geom_version++;
+	const ei_size_t size = widget->content_rect->size;
+	if(size.width == widget->children_size.width && size.height == widget->children_size.height)
+		return;
+
+	widget->children_size = size;
+	ei_widget_t *child = widget->children_head;
+	while(child) {
+		if(child->geom_params)
+			child->geom_params->manager->runfunc(child);
+		child = child->next_sibling;
+	}
 }
 
 void ei_register_placer_manager(void) {
@@ -0,0 +1,355 @@
+/**
+ *  @file	ei_image.c
+ *  @brief	Cache of the decoded images, keyed by file name. The images are converted to the
+ *		channel order of the root surface, and their transparent pixels are recorded.
+ *		Images can be decoded by a worker thread, without blocking the event loop, and
+ *		are kept decoded on disk between runs (see ei_image_disk.h).
+ *
+ */
+
+#include "ei_image.h"
+#include "ei_application.h"
+#include "ei_surface.h"
+#include "ei_draw.h"
+#include "ei_image_disk.h"
+#include <stdlib.h>
+#include <string.h>
+#ifndef __WIN__
+#include <pthread.h>
+#endif
+
+/* Number of buckets of the image table (power of 2) */
+#define IMAGE_BUCKETS 64
+
+
+/* A decoded image */
+typedef struct ei_image_entry_t {
+	char*			filename;	///< The name of the file (key).
+	ei_surface_t		image;		///< The image (the cache holds a reference).
+	struct ei_image_entry_t* next;		///< Next entry of the same bucket.
+} ei_image_entry_t;
+
+
+/* A background load (see ei_image_load_async) */
+typedef struct ei_image_request_t {
+	char*				filename;	///< The name of the file.
+	ei_surface_t			channels;	///< The surface giving the channel order (the root surface).
+	ei_surface_t			image;		///< The decoded image, set by the worker.
+	ei_bool_t			from_disk;	///< EI_TRUE if the image was loaded from the disk cache.
+	ei_bool_t			opaque;		///< The opacity of the image loaded from the disk cache.
+	ei_rect_t			visible;	///< Its bounding box of non transparent pixels.
+	ei_widget_t*			widget;		///< The widget, NULL if it was destroyed.
+	ei_bool_t			has_rect;	///< EI_TRUE if img_rect is used.
+	ei_rect_t			img_rect;	///< The subpart of the image to use.
+	struct ei_image_request_t*	next;		///< Next request of the pending list (event loop thread).
+	struct ei_image_request_t*	queue_next;	///< Next request to decode (shared with the worker).
+} ei_image_request_t;
+
+
+/* hash table of the images */
+static ei_image_entry_t *buckets[IMAGE_BUCKETS];
+
+/* requests whose event was not handled yet */
+static ei_image_request_t *pending = NULL;
+
+#ifndef __WIN__
+/* requests to decode, and the worker decoding them */
+static ei_image_request_t *queue_head = NULL;
+static ei_image_request_t *queue_tail = NULL;
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t worker;
+static ei_bool_t worker_running = EI_FALSE;
+static ei_bool_t worker_quit = EI_FALSE;
+#endif
+
+
+static unsigned bucket_of(const char* filename) {
+	/* FNV-1a */
+	unsigned hash = 2166136261u;
+	for(; *filename; filename++)
+		hash = (hash ^ (unsigned char)*filename) * 16777619u;
+	return hash & (IMAGE_BUCKETS - 1);
+}
+
+
+/* whether two formats have the same channel indices (the other orders are not told apart) */
+static ei_bool_t same_channels(const ei_pixel_format_t* a, const ei_pixel_format_t* b) {
+	return a->ir == b->ir && a->ig == b->ig && a->ib == b->ib && a->ia == b->ia;
+}
+
+
+ei_surface_t ei_image_convert(ei_surface_t image, ei_surface_t channels) {
+	const ei_pixel_format_t *f = ei_surface_format(image);
+	if(same_channels(f, ei_surface_format(channels)))
+		return image;
+
+	ei_surface_t converted = hw_surface_create(channels, hw_surface_get_size(image), EI_TRUE);
+	if(same_channels(ei_surface_format(converted), f)) {
+		/* the order of channels has no alpha channel: nothing to gain */
+		ei_surface_free(converted);
+		return image;
+	}
+	hw_surface_lock(converted);
+	hw_surface_lock(image);
+	ei_copy_surface(converted, NULL, image, NULL, EI_FALSE);
+	hw_surface_unlock(image);
+	hw_surface_unlock(converted);
+	ei_surface_free(image);
+	return converted;
+}
+
+
+void ei_image_scan_opacity(ei_surface_t surface) {
+	hw_surface_lock(surface);
+	ei_surface_desc_t desc = ei_surface_desc(surface);
+	int ia = desc.format->ia;
+
+	ei_bool_t opaque = EI_TRUE;
+	ei_rect_t visible = {{0, 0}, desc.size};
+	if(ia >= 0) {
+		int x0 = desc.size.width, y0 = desc.size.height, x1 = -1, y1 = -1;
+		for(int y = 0; y < desc.size.height; y++) {
+			const uint8_t *alpha = (const uint8_t *)EI_PIXEL_AT(&desc, 0, y) + ia;
+			for(int x = 0; x < desc.size.width; x++) {
+				if(alpha[4 * x] != 0xff)
+					opaque = EI_FALSE;
+				if(alpha[4 * x] != 0) {
+					x0 = x < x0 ? x : x0;
+					x1 = x > x1 ? x : x1;
+					y0 = y < y0 ? y : y0;
+					y1 = y;
+				}
+			}
+		}
+		visible = (x1 < 0) ? (ei_rect_t){{0, 0}, {0, 0}} : (ei_rect_t){{x0, y0}, {x1 - x0 + 1, y1 - y0 + 1}};
+	}
+	hw_surface_unlock(surface);
+
+	ei_surface_set_opacity(surface, opaque, &visible);
+}
+
+
+/* returns the cached image of a file with a reference for the caller, or NULL */
+static ei_surface_t lookup(const char* filename) {
+	for(ei_image_entry_t *entry = buckets[bucket_of(filename)]; entry; entry = entry->next) {
+		if(strcmp(entry->filename, filename) == 0) {
+			ei_surface_retain(entry->image);
+			return entry->image;
+		}
+	}
+	return NULL;
+}
+
+
+/* adds an image to the cache, and returns it with a reference for the caller. The opacity is
+   given (visible is not NULL) for the images of the disk cache, the other ones were just decoded */
+static ei_surface_t insert(const char* filename, ei_surface_t image, ei_bool_t opaque, const ei_rect_t* visible) {
+	/* the file may have been loaded in the meantime */
+	ei_surface_t cached = lookup(filename);
+	if(cached) {
+		ei_surface_free(image);
+		return cached;
+	}
+
+	if(visible)
+		ei_surface_set_opacity(image, opaque, visible);
+	else {
+		image = ei_image_convert(image, ei_app_root_surface());
+		ei_image_scan_opacity(image);
+		ei_rect_t scanned;
+		ei_surface_get_opacity(image, &opaque, &scanned);
+		ei_image_disk_store(filename, image, opaque, &scanned);
+	}
+
+	unsigned b = bucket_of(filename);
+	ei_image_entry_t *entry = malloc(sizeof(ei_image_entry_t));
+	entry->filename = strdup(filename);
+	entry->image = image;
+	entry->next = buckets[b];
+	buckets[b] = entry;
+
+	/* one reference for the cache, one for the caller */
+	ei_surface_retain(image);
+	return image;
+}
+
+
+ei_surface_t ei_image_load(const char* filename) {
+	ei_surface_t image = lookup(filename);
+	if(image)
+		return image;
+
+	/* first load of this file: from the disk cache, else decoded */
+	ei_bool_t opaque;
+	ei_rect_t visible;
+	image = ei_image_disk_load(filename, ei_app_root_surface(), &opaque, &visible);
+	if(image)
+		return insert(filename, image, opaque, &visible);
+	image = hw_image_load(filename, ei_app_root_surface());
+	if(!image)
+		return NULL;
+	return insert(filename, image, EI_FALSE, NULL);
+}
+
+
+/* configures the image of a frame or a button, keeping its requested size */
+static void configure_image(ei_widget_t* widget, ei_surface_t image, ei_rect_t* img_rect) {
+	ei_rect_t **rect_ptr = img_rect ? &img_rect : NULL;
+	if(strcmp(widget->wclass->name, "button") == 0)
+		ei_button_configure(widget, &widget->requested_size, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+				    &image, rect_ptr, NULL, NULL, NULL);
+	else
+		ei_frame_configure(widget, &widget->requested_size, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+				   &image, rect_ptr, NULL);
+}
+
+
+/* loads the image of a request, from the disk cache if possible (on the worker thread) */
+static void load(ei_image_request_t* request) {
+	request->image = ei_image_disk_load(request->filename, request->channels, &request->opaque, &request->visible);
+	request->from_disk = request->image ? EI_TRUE : EI_FALSE;
+	if(!request->image)
+		request->image = hw_image_load(request->filename, request->channels);
+}
+
+
+#ifndef __WIN__
+/* decodes the queued requests, and posts an event for each one */
+static void* worker_main(void* arg) {
+	(void)arg;
+	pthread_mutex_lock(&queue_mutex);
+	while(!worker_quit) {
+		ei_image_request_t *request = queue_head;
+		if(!request) {
+			pthread_cond_wait(&queue_cond, &queue_mutex);
+			continue;
+		}
+		queue_head = request->queue_next;
+		if(!queue_head)
+			queue_tail = NULL;
+		pthread_mutex_unlock(&queue_mutex);
+
+		load(request);
+		hw_event_post_app(request);
+
+		pthread_mutex_lock(&queue_mutex);
+	}
+	pthread_mutex_unlock(&queue_mutex);
+	return NULL;
+}
+#endif
+
+
+ei_bool_t ei_image_load_async(const char* filename, ei_widget_t* widget, const ei_rect_t* img_rect,
+			      ei_surface_t placeholder) {
+	if(strcmp(widget->wclass->name, "button") != 0 && strcmp(widget->wclass->name, "frame") != 0)
+		return EI_FALSE;
+
+	ei_rect_t rect = img_rect ? *img_rect : (ei_rect_t){{0, 0}, {0, 0}};
+	ei_surface_t image = lookup(filename);
+	if(image) {
+		configure_image(widget, image, img_rect ? &rect : NULL);
+		ei_surface_release(image);
+		return EI_TRUE;
+	}
+	if(placeholder)
+		configure_image(widget, placeholder, NULL);
+
+	ei_image_request_t *request = calloc(1, sizeof(ei_image_request_t));
+	request->filename = strdup(filename);
+	request->channels = ei_app_root_surface();
+	request->widget = widget;
+	request->has_rect = img_rect ? EI_TRUE : EI_FALSE;
+	request->img_rect = rect;
+	request->next = pending;
+	pending = request;
+
+#ifdef __WIN__
+	/* no worker thread: decoded at once, handled by the event loop like the others */
+	load(request);
+	hw_event_post_app(request);
+#else
+	pthread_mutex_lock(&queue_mutex);
+	if(!worker_running) {
+		/* resolved here, before the worker reads it: it never writes it */
+		ei_image_disk_directory();
+		worker_quit = EI_FALSE;
+		worker_running = (pthread_create(&worker, NULL, worker_main, NULL) == 0) ? EI_TRUE : EI_FALSE;
+	}
+	if(queue_tail)
+		queue_tail->queue_next = request;
+	else
+		queue_head = request;
+	queue_tail = request;
+	pthread_cond_signal(&queue_cond);
+	pthread_mutex_unlock(&queue_mutex);
+#endif
+	return EI_TRUE;
+}
+
+
+static void free_request(ei_image_request_t* request) {
+	free(request->filename);
+	free(request);
+}
+
+
+ei_bool_t ei_image_handle_event(const ei_event_t* event) {
+	ei_image_request_t **prev = &pending;
+	while(*prev && *prev != event->param.application.user_param)
+		prev = &(*prev)->next;
+	if(!*prev)
+		return EI_FALSE;
+
+	ei_image_request_t *request = *prev;
+	*prev = request->next;
+	if(request->image) {
+		ei_surface_t image = insert(request->filename, request->image, request->opaque,
+					    request->from_disk ? &request->visible : NULL);
+		if(request->widget)
+			configure_image(request->widget, image, request->has_rect ? &request->img_rect : NULL);
+		ei_surface_release(image);
+	}
+	free_request(request);
+	return EI_TRUE;
+}
+
+
+void ei_image_forget_widget(ei_widget_t* widget) {
+	for(ei_image_request_t *request = pending; request; request = request->next)
+		if(request->widget == widget)
+			request->widget = NULL;
+}
+
+
+void ei_image_cache_free(void) {
+#ifndef __WIN__
+	/* stops the worker (it finishes the image it is decoding) */
+	pthread_mutex_lock(&queue_mutex);
+	worker_quit = EI_TRUE;
+	pthread_cond_signal(&queue_cond);
+	pthread_mutex_unlock(&queue_mutex);
+	if(worker_running)
+		pthread_join(worker, NULL);
+	worker_running = EI_FALSE;
+	queue_head = queue_tail = NULL;
+#endif
+	while(pending) {
+		ei_image_request_t *request = pending;
+		pending = request->next;
+		if(request->image)
+			ei_surface_free(request->image);
+		free_request(request);
+	}
+
+	for(int b = 0; b < IMAGE_BUCKETS; b++) {
+		while(buckets[b]) {
+			ei_image_entry_t *entry = buckets[b];
+			buckets[b] = entry->next;
+			ei_surface_release(entry->image);
+			free(entry->filename);
+			free(entry);
+		}
+	}
+}
@@ -0,0 +1,180 @@
+/**
+ *  @file	ei_image_disk.c
+ *  @brief	Persistent cache of the decoded images: the converted pixels of an image are
+ *		stored in a file of a cache directory, and mapped in memory at the next runs
+ *		instead of decoding the image again.
+ *
+ */
+
+#include "ei_image_disk.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifndef __WIN__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* identifies the cache files, and their version */
+#define DISK_MAGIC "EIIMG01"
+
+
+/* Header of a cache file, followed by the name of the image file (padded to 64 bytes) and the
+   pixels (width x height, without padding) */
+typedef struct ei_disk_header_t {
+	char		magic[8];	///< DISK_MAGIC.
+	int64_t		mtime;		///< Modification time of the image file.
+	int64_t		file_size;	///< Size of the image file.
+	int32_t		width;		///< Width of the image.
+	int32_t		height;		///< Height of the image.
+	int32_t		channels[4];	///< Indices of the red, green, blue and alpha channels.
+	int32_t		opaque;		///< Opacity of the image.
+	int32_t		visible[4];	///< Bounding box of the non transparent pixels (x, y, width, height).
+	int32_t		name_length;	///< Length of the name of the image file.
+} ei_disk_header_t;
+
+
+static char *directory = NULL;
+static ei_bool_t directory_set = EI_FALSE;
+
+
+void ei_image_disk_set_directory(const char* dir) {
+	free(directory);
+	directory = dir ? strdup(dir) : NULL;
+	directory_set = EI_TRUE;
+}
+
+
+const char* ei_image_disk_directory(void) {
+	if(!directory_set)
+		ei_image_disk_set_directory(getenv("EI_IMAGE_CACHE"));
+	return directory;
+}
+
+
+#ifndef __WIN__
+
+
+/* name of the cache file of an image file */
+static void cache_path(char* path, size_t size, const char* filename) {
+	/* FNV-1a, 64 bits */
+	uint64_t hash = 14695981039346656037ull;
+	for(const char *c = filename; *c; c++)
+		hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+	snprintf(path, size, "%s/%016llx.eic", ei_image_disk_directory(), (unsigned long long)hash);
+}
+
+
+static size_t pixels_offset(int name_length) {
+	return (sizeof(ei_disk_header_t) + name_length + 63) & ~(size_t)63;
+}
+
+
+ei_surface_t ei_image_disk_load(const char* filename, ei_surface_t channels, ei_bool_t* opaque, ei_rect_t* visible) {
+	struct stat source;
+	if(!ei_image_disk_directory() || stat(filename, &source) != 0)
+		return NULL;
+
+	char path[1024];
+	cache_path(path, sizeof(path), filename);
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return NULL;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ei_disk_header_t)) {
+		close(fd);
+		return NULL;
+	}
+	const uint8_t *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+		return NULL;
+
+	/* checks that the file is the cache of this version of the image */
+	ei_surface_t image = NULL;
+	const ei_disk_header_t *header = (const ei_disk_header_t *)map;
+	size_t name_length = strlen(filename);
+	size_t offset = pixels_offset(name_length);
+	if(memcmp(header->magic, DISK_MAGIC, sizeof(DISK_MAGIC)) == 0 &&
+	   header->mtime == (int64_t)source.st_mtime && header->file_size == (int64_t)source.st_size &&
+	   header->name_length == (int32_t)name_length && header->width > 0 && header->height > 0 &&
+	   memcmp(map + sizeof(ei_disk_header_t), filename, name_length) == 0 &&
+	   (size_t)st.st_size >= offset + (size_t)header->width * header->height * 4) {
+		ei_size_t size = {header->width, header->height};
+		image = hw_surface_create(channels, size, EI_TRUE);
+
+		/* the pixels must be in the channel order of the new surface */
+		int ir, ig, ib, ia;
+		hw_surface_get_channel_indices(image, &ir, &ig, &ib, &ia);
+		if(ir == header->channels[0] && ig == header->channels[1] && ib == header->channels[2] && ia == header->channels[3]) {
+			madvise((void *)map, st.st_size, MADV_SEQUENTIAL);
+			hw_surface_lock(image);
+			memcpy(hw_surface_get_buffer(image), map + offset, (size_t)size.width * size.height * 4);
+			hw_surface_unlock(image);
+			*opaque = header->opaque ? EI_TRUE : EI_FALSE;
+			*visible = (ei_rect_t){{header->visible[0], header->visible[1]}, {header->visible[2], header->visible[3]}};
+		} else {
+			hw_surface_free(image);
+			image = NULL;
+		}
+	}
+	munmap((void *)map, st.st_size);
+	return image;
+}
+
+
+void ei_image_disk_store(const char* filename, ei_surface_t image, ei_bool_t opaque, const ei_rect_t* visible) {
+	struct stat source;
+	if(!ei_image_disk_directory() || stat(filename, &source) != 0)
+		return;
+
+	ei_disk_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, DISK_MAGIC, sizeof(DISK_MAGIC));
+	header.mtime = source.st_mtime;
+	header.file_size = source.st_size;
+	ei_size_t size = hw_surface_get_size(image);
+	header.width = size.width;
+	header.height = size.height;
+	hw_surface_get_channel_indices(image, &header.channels[0], &header.channels[1], &header.channels[2], &header.channels[3]);
+	header.opaque = opaque;
+	header.visible[0] = visible->top_left.x;
+	header.visible[1] = visible->top_left.y;
+	header.visible[2] = visible->size.width;
+	header.visible[3] = visible->size.height;
+	header.name_length = strlen(filename);
+
+	/* written in a temporary file, renamed when it is complete */
+	char path[1024], tmp_path[1040];
+	cache_path(path, sizeof(path), filename);
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+	FILE *file = fopen(tmp_path, "wb");
+	if(!file)
+		return;
+	static const char padding[64];
+	size_t offset = pixels_offset(header.name_length);
+	hw_surface_lock(image);
+	ei_bool_t ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		       fwrite(filename, 1, header.name_length, file) == (size_t)header.name_length &&
+		       fwrite(padding, 1, offset - sizeof(header) - header.name_length, file) == offset - sizeof(header) - header.name_length &&
+		       fwrite(hw_surface_get_buffer(image), 4, (size_t)size.width * size.height, file) == (size_t)size.width * size.height;
+	hw_surface_unlock(image);
+	if(fclose(file) != 0 || !ok || rename(tmp_path, path) != 0)
+		remove(tmp_path);
+}
+
+#else
+
+/* no memory mapping: the cache is disabled */
+ei_surface_t ei_image_disk_load(const char* filename, ei_surface_t channels, ei_bool_t* opaque, ei_rect_t* visible) {
+	return NULL;
+}
+
+
+void ei_image_disk_store(const char* filename, ei_surface_t image, ei_bool_t opaque, const ei_rect_t* visible) {
+}
+
+#endif
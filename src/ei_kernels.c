@@ -0,0 +1,270 @@
+/**
+ *  @file	ei_kernels.c
+ *  @brief	Scalar pixel kernels, and selection of the kernel variant at run time.
+ *
+ */
+
+#include "ei_kernels.h"
+#include "ei_calculations.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* signature of the swizzle and blend kernels */
+typedef void (*ei_convert_kernel_t)(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				    int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf);
+
+/* body of the swizzle kernels */
+#define SWIZZLE_BODY(SR, SG, SB, SA, DR, DG, DB, DA) \
+	for(int y = 0; y < height; y++) { \
+		for(int x = 0; x < width; x++) { \
+			uint32_t s = src[x]; \
+			dst[x] = EI_PACK(EI_CHANNEL(s, SR), EI_CHANNEL(s, SG), EI_CHANNEL(s, SB), EI_ALPHA(s, SA), DR, DG, DB, DA); \
+		} \
+		dst += dst_pitch; \
+		src += src_pitch; \
+	}
+
+/* body of the blending kernels: weighted mean by the alpha of the source, the result is opaque */
+#define BLEND_BODY(SR, SG, SB, SA, DR, DG, DB, DA) \
+	for(int y = 0; y < height; y++) { \
+		for(int x = 0; x < width; x++) { \
+			uint32_t s = src[x]; \
+			uint32_t d = dst[x]; \
+			float cnl = ((float)EI_ALPHA(s, SA))/256; \
+			dst[x] = EI_PACK((unsigned char)(EI_CHANNEL(s, SR)*cnl + EI_CHANNEL(d, DR)*(1-cnl)), \
+					 (unsigned char)(EI_CHANNEL(s, SG)*cnl + EI_CHANNEL(d, DG)*(1-cnl)), \
+					 (unsigned char)(EI_CHANNEL(s, SB)*cnl + EI_CHANNEL(d, DB)*(1-cnl)), \
+					 255, DR, DG, DB, DA); \
+		} \
+		dst += dst_pitch; \
+		src += src_pitch; \
+	}
+
+/* the specialized channel orders, as (name, ir, ig, ib, ia) */
+#define SRC_ORDERS(M) \
+	M(rgba, 0, 1, 2, 3) M(bgra, 2, 1, 0, 3) M(argb, 1, 2, 3, 0) M(abgr, 3, 2, 1, 0)
+#define DST_ORDERS(M, s, SR, SG, SB, SA) \
+	M(s, SR, SG, SB, SA, rgba, 0, 1, 2, 3) M(s, SR, SG, SB, SA, bgra, 2, 1, 0, 3) \
+	M(s, SR, SG, SB, SA, argb, 1, 2, 3, 0) M(s, SR, SG, SB, SA, abgr, 3, 2, 1, 0)
+
+/* one swizzle and one blending kernel for each couple of orders, with constant shifts */
+#define DEFINE_KERNELS(s, SR, SG, SB, SA, d, DR, DG, DB, DA) \
+	static void swizzle_##s##_##d(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch, \
+				      int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) { \
+		SWIZZLE_BODY(SR, SG, SB, SA, DR, DG, DB, DA) \
+	} \
+	static void blend_##s##_##d(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch, \
+				    int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) { \
+		BLEND_BODY(SR, SG, SB, SA, DR, DG, DB, DA) \
+	}
+#define DEFINE_KERNELS_FROM(s, SR, SG, SB, SA) DST_ORDERS(DEFINE_KERNELS, s, SR, SG, SB, SA)
+SRC_ORDERS(DEFINE_KERNELS_FROM)
+
+/* generic kernels, for the other orders */
+static void swizzle_generic(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+			    int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) {
+	SWIZZLE_BODY(sf->ir, sf->ig, sf->ib, sf->ia, df->ir, df->ig, df->ib, df->ia)
+}
+
+static void blend_generic(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+			  int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) {
+	BLEND_BODY(sf->ir, sf->ig, sf->ib, sf->ia, df->ir, df->ig, df->ib, df->ia)
+}
+
+/* kernel tables, indexed by [source order][destination order] */
+#define SWIZZLE_ENTRY(s, SR, SG, SB, SA, d, DR, DG, DB, DA) [ei_pixel_order_##s][ei_pixel_order_##d] = swizzle_##s##_##d,
+#define BLEND_ENTRY(s, SR, SG, SB, SA, d, DR, DG, DB, DA) [ei_pixel_order_##s][ei_pixel_order_##d] = blend_##s##_##d,
+#define SWIZZLE_ENTRIES_FROM(s, SR, SG, SB, SA) DST_ORDERS(SWIZZLE_ENTRY, s, SR, SG, SB, SA)
+#define BLEND_ENTRIES_FROM(s, SR, SG, SB, SA) DST_ORDERS(BLEND_ENTRY, s, SR, SG, SB, SA)
+
+static const ei_convert_kernel_t swizzle_kernels[ei_pixel_order_other][ei_pixel_order_other] = { SRC_ORDERS(SWIZZLE_ENTRIES_FROM) };
+static const ei_convert_kernel_t blend_kernels[ei_pixel_order_other][ei_pixel_order_other] = { SRC_ORDERS(BLEND_ENTRIES_FROM) };
+
+
+static void scalar_fill(uint32_t* dst, int dst_pitch, int width, int height, uint32_t value) {
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++)
+			dst[x] = value;
+		dst += dst_pitch;
+	}
+}
+
+
+static void scalar_copy(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch, int width, int height) {
+	for(int y = 0; y < height; y++) {
+		memcpy(dst, src, width * sizeof(uint32_t));
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+static void scalar_swizzle(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+			   int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) {
+	if(sf->order == ei_pixel_order_other || df->order == ei_pixel_order_other)
+		swizzle_generic(dst, dst_pitch, src, src_pitch, width, height, df, sf);
+	else
+		swizzle_kernels[sf->order][df->order](dst, dst_pitch, src, src_pitch, width, height, df, sf);
+}
+
+
+static void scalar_blend(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+			 int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) {
+	if(sf->order == ei_pixel_order_other || df->order == ei_pixel_order_other)
+		blend_generic(dst, dst_pitch, src, src_pitch, width, height, df, sf);
+	else
+		blend_kernels[sf->order][df->order](dst, dst_pitch, src, src_pitch, width, height, df, sf);
+}
+
+
+static void scalar_mask_tint(uint32_t* dst, int dst_pitch, const uint8_t* mask, int mask_step, int mask_pitch,
+			     int width, int height, const ei_pixel_format_t* df, ei_color_t color) {
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			uint32_t d = dst[x];
+			float cnl = ((float)mask[x * mask_step])/256;
+			dst[x] = EI_PACK((unsigned char)(color.red*cnl + EI_CHANNEL(d, df->ir)*(1-cnl)),
+					 (unsigned char)(color.green*cnl + EI_CHANNEL(d, df->ig)*(1-cnl)),
+					 (unsigned char)(color.blue*cnl + EI_CHANNEL(d, df->ib)*(1-cnl)),
+					 255, df->ir, df->ig, df->ib, df->ia);
+		}
+		dst += dst_pitch;
+		mask += mask_pitch;
+	}
+}
+
+
+static void scalar_blend_premul(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf,
+				ei_bool_t src_premultiplied) {
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			uint32_t s = src[x];
+			uint32_t d = dst[x];
+			uint32_t a = EI_ALPHA(s, sf->ia);
+			uint32_t r, g, b;
+			if(src_premultiplied) {
+				r = min(255, EI_CHANNEL(s, sf->ir) + EI_DIV255(EI_CHANNEL(d, df->ir) * (255 - a)));
+				g = min(255, EI_CHANNEL(s, sf->ig) + EI_DIV255(EI_CHANNEL(d, df->ig) * (255 - a)));
+				b = min(255, EI_CHANNEL(s, sf->ib) + EI_DIV255(EI_CHANNEL(d, df->ib) * (255 - a)));
+			} else {
+				r = EI_DIV255(EI_CHANNEL(s, sf->ir) * a + EI_CHANNEL(d, df->ir) * (255 - a));
+				g = EI_DIV255(EI_CHANNEL(s, sf->ig) * a + EI_CHANNEL(d, df->ig) * (255 - a));
+				b = EI_DIV255(EI_CHANNEL(s, sf->ib) * a + EI_CHANNEL(d, df->ib) * (255 - a));
+			}
+			dst[x] = EI_PACK(r, g, b, a + EI_DIV255(EI_ALPHA(d, df->ia) * (255 - a)), df->ir, df->ig, df->ib, df->ia);
+		}
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+static void scalar_mask_tint_premul(uint32_t* dst, int dst_pitch, const uint8_t* mask, int mask_step, int mask_pitch,
+				    int width, int height, const ei_pixel_format_t* df, ei_color_t color) {
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			uint32_t d = dst[x];
+			uint32_t a = EI_DIV255(mask[x * mask_step] * color.alpha);
+			dst[x] = EI_PACK(EI_DIV255(color.red * a + EI_CHANNEL(d, df->ir) * (255 - a)),
+					 EI_DIV255(color.green * a + EI_CHANNEL(d, df->ig) * (255 - a)),
+					 EI_DIV255(color.blue * a + EI_CHANNEL(d, df->ib) * (255 - a)),
+					 a + EI_DIV255(EI_ALPHA(d, df->ia) * (255 - a)), df->ir, df->ig, df->ib, df->ia);
+		}
+		dst += dst_pitch;
+		mask += mask_pitch;
+	}
+}
+
+
+static void scalar_scale_nearest(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				 int width, int height, const int* xs, const int* ys) {
+	for(int y = 0; y < height; y++) {
+		const uint32_t *row = src + ys[y] * src_pitch;
+		for(int x = 0; x < width; x++)
+			dst[x] = row[xs[x]];
+		dst += dst_pitch;
+	}
+}
+
+
+/* mix of the 4 channels of two pixels, with the weights 256 - w and w */
+static uint32_t lerp_pixel(uint32_t p0, uint32_t p1, uint32_t w) {
+	uint32_t result = 0;
+	for(int i = 0; i < 4; i++)
+		result |= ((EI_CHANNEL(p0, i) * (256 - w) + EI_CHANNEL(p1, i) * w + 128) >> 8) << (8 * i);
+	return result;
+}
+
+
+static void scalar_scale_bilinear(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				  int width, int height, const int* xs0, const int* xs1, const uint8_t* xw,
+				  const int* ys0, const int* ys1, const uint8_t* yw) {
+	for(int y = 0; y < height; y++) {
+		const uint32_t *row0 = src + ys0[y] * src_pitch;
+		const uint32_t *row1 = src + ys1[y] * src_pitch;
+		for(int x = 0; x < width; x++)
+			dst[x] = lerp_pixel(lerp_pixel(row0[xs0[x]], row0[xs1[x]], xw[x]),
+					    lerp_pixel(row1[xs0[x]], row1[xs1[x]], xw[x]), yw[y]);
+		dst += dst_pitch;
+	}
+}
+
+
+const ei_kernels_t ei_kernels_scalar = {
+	"scalar",
+	scalar_fill,
+	scalar_copy,
+	scalar_swizzle,
+	scalar_blend,
+	scalar_mask_tint,
+	scalar_blend_premul,
+	scalar_mask_tint_premul,
+	scalar_scale_nearest,
+	scalar_scale_bilinear
+};
+
+
+/* the selected variant */
+static const ei_kernels_t *selected = NULL;
+/* names of the variants for EI_KERNELS, from the slowest to the fastest */
+static const char *variant_names[3] = {"scalar", "sse2", "avx2"};
+
+
+void ei_kernels_init(void) {
+	/* the available variants */
+	const ei_kernels_t *variants[3] = {&ei_kernels_scalar, NULL, NULL};
+#ifdef EI_KERNELS_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("sse2"))
+		variants[1] = &ei_kernels_sse2;
+	if(__builtin_cpu_supports("avx2"))
+		variants[2] = &ei_kernels_avx2;
+#endif
+
+	int best = 0;
+	while(best < 2 && variants[best + 1])
+		best++;
+	selected = variants[best];
+
+	/* forced variant (benchmarking, validation) */
+	const char *forced = getenv("EI_KERNELS");
+	if(forced && *forced) {
+		int i = 0;
+		while(i < 3 && strcmp(forced, variant_names[i]))
+			i++;
+		if(i < 3 && variants[i])
+			selected = variants[i];
+		else
+			fprintf(stderr, "EI_KERNELS=%s is not available on this processor, using %s\n", forced, selected->name);
+	}
+}
+
+
+const ei_kernels_t* ei_kernels(void) {
+	if(!selected)
+		ei_kernels_init();
+	return selected;
+}
@@ -0,0 +1,592 @@
+/**
+ *  @file	ei_kernels_x86.c
+ *  @brief	SSE2 and AVX2 variants of the pixel kernels. They compute exactly the same pixels
+ *		as the scalar kernels (the remaining columns of each row are left to them).
+ *
+ */
+
+#include "ei_kernels.h"
+
+#ifdef EI_KERNELS_X86
+
+#include <string.h>
+#include <immintrin.h>
+
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+
+
+/*
+ * SSE2: 4 pixels at a time.
+ */
+
+/* channel of index i of 4 pixels, as 4 int32 (opaque alpha if i is -1) */
+SSE2 static inline __m128i sse2_channel(__m128i pixels, int i) {
+	if(i < 0)
+		return _mm_set1_epi32(0xff);
+	return _mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(8 * i)), _mm_set1_epi32(0xff));
+}
+
+/* moves 4 channels to the index i of the pixels (nothing if i is -1) */
+SSE2 static inline __m128i sse2_place(__m128i channel, int i) {
+	if(i < 0)
+		return _mm_setzero_si128();
+	return _mm_sll_epi32(channel, _mm_cvtsi32_si128(8 * i));
+}
+
+/* (int)(s*cnl + d*inv) for 4 channels */
+SSE2 static inline __m128i sse2_mix(__m128i s, __m128i d, __m128 cnl, __m128 inv) {
+	return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(s), cnl), _mm_mul_ps(_mm_cvtepi32_ps(d), inv)));
+}
+
+
+/* x / 255 rounded, for 4 int32 (0 <= x <= 255 * 255) */
+SSE2 static inline __m128i sse2_div255(__m128i x) {
+	x = _mm_add_epi32(x, _mm_set1_epi32(128));
+	return _mm_srli_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 8)), 8);
+}
+
+/* a * b for 4 int32 lower than 256 (the products fit in the low 16 bits of the lanes) */
+SSE2 static inline __m128i sse2_mul8(__m128i a, __m128i b) {
+	return _mm_mullo_epi16(a, b);
+}
+
+
+SSE2 static void sse2_fill(uint32_t* dst, int dst_pitch, int width, int height, uint32_t value) {
+	__m128i v = _mm_set1_epi32((int)value);
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 4 <= width; x += 4)
+			_mm_storeu_si128((__m128i*)(dst + x), v);
+		for(; x < width; x++)
+			dst[x] = value;
+		dst += dst_pitch;
+	}
+}
+
+
+SSE2 static void sse2_copy(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch, int width, int height) {
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 4 <= width; x += 4)
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_loadu_si128((const __m128i*)(src + x)));
+		for(; x < width; x++)
+			dst[x] = src[x];
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+SSE2 static void sse2_swizzle(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+			      int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) {
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 4 <= width; x += 4) {
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+			__m128i d = _mm_or_si128(_mm_or_si128(sse2_place(sse2_channel(s, sf->ir), df->ir),
+							      sse2_place(sse2_channel(s, sf->ig), df->ig)),
+						 _mm_or_si128(sse2_place(sse2_channel(s, sf->ib), df->ib),
+							      sse2_place(sse2_channel(s, sf->ia), df->ia)));
+			_mm_storeu_si128((__m128i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.swizzle(dst + x, dst_pitch, src + x, src_pitch, width - x, 1, df, sf);
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+SSE2 static void sse2_blend(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+			    int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) {
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128i opaque = sse2_place(_mm_set1_epi32(0xff), df->ia);
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 4 <= width; x += 4) {
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+			__m128 cnl = _mm_mul_ps(_mm_cvtepi32_ps(sse2_channel(s, sf->ia)), _mm_set1_ps(1.0f/256));
+			__m128 inv = _mm_sub_ps(one, cnl);
+			__m128i r = sse2_mix(sse2_channel(s, sf->ir), sse2_channel(d, df->ir), cnl, inv);
+			__m128i g = sse2_mix(sse2_channel(s, sf->ig), sse2_channel(d, df->ig), cnl, inv);
+			__m128i b = sse2_mix(sse2_channel(s, sf->ib), sse2_channel(d, df->ib), cnl, inv);
+			d = _mm_or_si128(_mm_or_si128(sse2_place(r, df->ir), sse2_place(g, df->ig)),
+					 _mm_or_si128(sse2_place(b, df->ib), opaque));
+			_mm_storeu_si128((__m128i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.blend(dst + x, dst_pitch, src + x, src_pitch, width - x, 1, df, sf);
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+SSE2 static void sse2_mask_tint(uint32_t* dst, int dst_pitch, const uint8_t* mask, int mask_step, int mask_pitch,
+				int width, int height, const ei_pixel_format_t* df, ei_color_t color) {
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128i cr = _mm_set1_epi32(color.red);
+	__m128i cg = _mm_set1_epi32(color.green);
+	__m128i cb = _mm_set1_epi32(color.blue);
+	__m128i opaque = sse2_place(_mm_set1_epi32(0xff), df->ia);
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 4 <= width; x += 4) {
+			__m128i m;
+			if(mask_step == 1) {
+				uint32_t m4;
+				memcpy(&m4, mask + x, sizeof(m4));
+				m = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)m4), _mm_setzero_si128()), _mm_setzero_si128());
+			} else
+				m = _mm_setr_epi32(mask[x * mask_step], mask[(x + 1) * mask_step],
+						   mask[(x + 2) * mask_step], mask[(x + 3) * mask_step]);
+
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+			__m128 cnl = _mm_mul_ps(_mm_cvtepi32_ps(m), _mm_set1_ps(1.0f/256));
+			__m128 inv = _mm_sub_ps(one, cnl);
+			__m128i r = sse2_mix(cr, sse2_channel(d, df->ir), cnl, inv);
+			__m128i g = sse2_mix(cg, sse2_channel(d, df->ig), cnl, inv);
+			__m128i b = sse2_mix(cb, sse2_channel(d, df->ib), cnl, inv);
+			d = _mm_or_si128(_mm_or_si128(sse2_place(r, df->ir), sse2_place(g, df->ig)),
+					 _mm_or_si128(sse2_place(b, df->ib), opaque));
+			_mm_storeu_si128((__m128i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.mask_tint(dst + x, dst_pitch, mask + x * mask_step, mask_step, mask_pitch, width - x, 1, df, color);
+		dst += dst_pitch;
+		mask += mask_pitch;
+	}
+}
+
+
+SSE2 static void sse2_blend_premul(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				   int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf,
+				   ei_bool_t src_premultiplied) {
+	__m128i full = _mm_set1_epi32(255);
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 4 <= width; x += 4) {
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+			__m128i a = sse2_channel(s, sf->ia);
+			__m128i inv = _mm_sub_epi32(full, a);
+			__m128i c[3];
+			const int si[3] = {sf->ir, sf->ig, sf->ib};
+			const int di[3] = {df->ir, df->ig, df->ib};
+			for(int i = 0; i < 3; i++) {
+				__m128i sc = sse2_channel(s, si[i]);
+				__m128i dc = sse2_mul8(sse2_channel(d, di[i]), inv);
+				if(src_premultiplied)
+					c[i] = _mm_min_epi16(_mm_add_epi32(sc, sse2_div255(dc)), full);
+				else
+					c[i] = sse2_div255(_mm_add_epi32(sse2_mul8(sc, a), dc));
+			}
+			__m128i oa = _mm_add_epi32(a, sse2_div255(sse2_mul8(sse2_channel(d, df->ia), inv)));
+			d = _mm_or_si128(_mm_or_si128(sse2_place(c[0], df->ir), sse2_place(c[1], df->ig)),
+					 _mm_or_si128(sse2_place(c[2], df->ib), sse2_place(oa, df->ia)));
+			_mm_storeu_si128((__m128i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.blend_premul(dst + x, dst_pitch, src + x, src_pitch, width - x, 1, df, sf, src_premultiplied);
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+SSE2 static void sse2_mask_tint_premul(uint32_t* dst, int dst_pitch, const uint8_t* mask, int mask_step, int mask_pitch,
+				       int width, int height, const ei_pixel_format_t* df, ei_color_t color) {
+	__m128i full = _mm_set1_epi32(255);
+	__m128i ca = _mm_set1_epi32(color.alpha);
+	__m128i cc[3] = {_mm_set1_epi32(color.red), _mm_set1_epi32(color.green), _mm_set1_epi32(color.blue)};
+	const int di[3] = {df->ir, df->ig, df->ib};
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 4 <= width; x += 4) {
+			__m128i m;
+			if(mask_step == 1) {
+				uint32_t m4;
+				memcpy(&m4, mask + x, sizeof(m4));
+				m = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)m4), _mm_setzero_si128()), _mm_setzero_si128());
+			} else
+				m = _mm_setr_epi32(mask[x * mask_step], mask[(x + 1) * mask_step],
+						   mask[(x + 2) * mask_step], mask[(x + 3) * mask_step]);
+
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+			__m128i a = sse2_div255(sse2_mul8(m, ca));
+			__m128i inv = _mm_sub_epi32(full, a);
+			__m128i c[3];
+			for(int i = 0; i < 3; i++)
+				c[i] = sse2_div255(_mm_add_epi32(sse2_mul8(cc[i], a), sse2_mul8(sse2_channel(d, di[i]), inv)));
+			__m128i oa = _mm_add_epi32(a, sse2_div255(sse2_mul8(sse2_channel(d, df->ia), inv)));
+			d = _mm_or_si128(_mm_or_si128(sse2_place(c[0], df->ir), sse2_place(c[1], df->ig)),
+					 _mm_or_si128(sse2_place(c[2], df->ib), sse2_place(oa, df->ia)));
+			_mm_storeu_si128((__m128i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.mask_tint_premul(dst + x, dst_pitch, mask + x * mask_step, mask_step, mask_pitch, width - x, 1, df, color);
+		dst += dst_pitch;
+		mask += mask_pitch;
+	}
+}
+
+
+SSE2 static void sse2_scale_nearest(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				    int width, int height, const int* xs, const int* ys) {
+	for(int y = 0; y < height; y++) {
+		const uint32_t *row = src + ys[y] * src_pitch;
+		int x = 0;
+		for(; x + 4 <= width; x += 4)
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_setr_epi32((int)row[xs[x]], (int)row[xs[x + 1]],
+									   (int)row[xs[x + 2]], (int)row[xs[x + 3]]));
+		for(; x < width; x++)
+			dst[x] = row[xs[x]];
+		dst += dst_pitch;
+	}
+}
+
+
+/* (p0 * (256 - w) + p1 * w + 128) >> 8 for 8 channels as uint16 (the sums fit in 16 bits) */
+SSE2 static inline __m128i sse2_lerp16(__m128i p0, __m128i p1, __m128i w) {
+	__m128i inv = _mm_sub_epi16(_mm_set1_epi16(256), w);
+	__m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(p0, inv), _mm_mullo_epi16(p1, w)), _mm_set1_epi16(128));
+	return _mm_srli_epi16(sum, 8);
+}
+
+
+SSE2 static void sse2_scale_bilinear(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				     int width, int height, const int* xs0, const int* xs1, const uint8_t* xw,
+				     const int* ys0, const int* ys1, const uint8_t* yw) {
+	const __m128i zero = _mm_setzero_si128();
+	for(int y = 0; y < height; y++) {
+		const uint32_t *row0 = src + ys0[y] * src_pitch;
+		const uint32_t *row1 = src + ys1[y] * src_pitch;
+		__m128i wy = _mm_set1_epi16(yw[y]);
+		int x = 0;
+		for(; x + 4 <= width; x += 4) {
+			__m128i p00 = _mm_setr_epi32((int)row0[xs0[x]], (int)row0[xs0[x + 1]], (int)row0[xs0[x + 2]], (int)row0[xs0[x + 3]]);
+			__m128i p01 = _mm_setr_epi32((int)row0[xs1[x]], (int)row0[xs1[x + 1]], (int)row0[xs1[x + 2]], (int)row0[xs1[x + 3]]);
+			__m128i p10 = _mm_setr_epi32((int)row1[xs0[x]], (int)row1[xs0[x + 1]], (int)row1[xs0[x + 2]], (int)row1[xs0[x + 3]]);
+			__m128i p11 = _mm_setr_epi32((int)row1[xs1[x]], (int)row1[xs1[x + 1]], (int)row1[xs1[x + 2]], (int)row1[xs1[x + 3]]);
+			/* the weight of each pixel in its 4 channels, unpacked like the pixels */
+			__m128i w = _mm_setr_epi32((int)(xw[x] * 0x01010101u), (int)(xw[x + 1] * 0x01010101u),
+						   (int)(xw[x + 2] * 0x01010101u), (int)(xw[x + 3] * 0x01010101u));
+			__m128i wlo = _mm_unpacklo_epi8(w, zero), whi = _mm_unpackhi_epi8(w, zero);
+
+			__m128i lo = sse2_lerp16(sse2_lerp16(_mm_unpacklo_epi8(p00, zero), _mm_unpacklo_epi8(p01, zero), wlo),
+						 sse2_lerp16(_mm_unpacklo_epi8(p10, zero), _mm_unpacklo_epi8(p11, zero), wlo), wy);
+			__m128i hi = sse2_lerp16(sse2_lerp16(_mm_unpackhi_epi8(p00, zero), _mm_unpackhi_epi8(p01, zero), whi),
+						 sse2_lerp16(_mm_unpackhi_epi8(p10, zero), _mm_unpackhi_epi8(p11, zero), whi), wy);
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+		}
+		if(x < width)
+			ei_kernels_scalar.scale_bilinear(dst + x, dst_pitch, src, src_pitch, width - x, 1,
+							 xs0 + x, xs1 + x, xw + x, ys0 + y, ys1 + y, yw + y);
+		dst += dst_pitch;
+	}
+}
+
+
+const ei_kernels_t ei_kernels_sse2 = {
+	"sse2",
+	sse2_fill,
+	sse2_copy,
+	sse2_swizzle,
+	sse2_blend,
+	sse2_mask_tint,
+	sse2_blend_premul,
+	sse2_mask_tint_premul,
+	sse2_scale_nearest,
+	sse2_scale_bilinear
+};
+
+
+/*
+ * AVX2: 8 pixels at a time.
+ */
+
+/* channel of index i of 8 pixels, as 8 int32 (opaque alpha if i is -1) */
+AVX2 static inline __m256i avx2_channel(__m256i pixels, int i) {
+	if(i < 0)
+		return _mm256_set1_epi32(0xff);
+	return _mm256_and_si256(_mm256_srl_epi32(pixels, _mm_cvtsi32_si128(8 * i)), _mm256_set1_epi32(0xff));
+}
+
+/* moves 8 channels to the index i of the pixels (nothing if i is -1) */
+AVX2 static inline __m256i avx2_place(__m256i channel, int i) {
+	if(i < 0)
+		return _mm256_setzero_si256();
+	return _mm256_sll_epi32(channel, _mm_cvtsi32_si128(8 * i));
+}
+
+/* (int)(s*cnl + d*inv) for 8 channels */
+AVX2 static inline __m256i avx2_mix(__m256i s, __m256i d, __m256 cnl, __m256 inv) {
+	return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(s), cnl), _mm256_mul_ps(_mm256_cvtepi32_ps(d), inv)));
+}
+
+
+/* x / 255 rounded, for 8 int32 (0 <= x <= 255 * 255) */
+AVX2 static inline __m256i avx2_div255(__m256i x) {
+	x = _mm256_add_epi32(x, _mm256_set1_epi32(128));
+	return _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(x, 8)), 8);
+}
+
+/* a * b for 8 int32 lower than 256 (the products fit in the low 16 bits of the lanes) */
+AVX2 static inline __m256i avx2_mul8(__m256i a, __m256i b) {
+	return _mm256_mullo_epi16(a, b);
+}
+
+
+AVX2 static void avx2_fill(uint32_t* dst, int dst_pitch, int width, int height, uint32_t value) {
+	__m256i v = _mm256_set1_epi32((int)value);
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+			_mm256_storeu_si256((__m256i*)(dst + x), v);
+		for(; x < width; x++)
+			dst[x] = value;
+		dst += dst_pitch;
+	}
+}
+
+
+AVX2 static void avx2_copy(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch, int width, int height) {
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+			_mm256_storeu_si256((__m256i*)(dst + x), _mm256_loadu_si256((const __m256i*)(src + x)));
+		for(; x < width; x++)
+			dst[x] = src[x];
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+AVX2 static void avx2_swizzle(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+			      int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) {
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8) {
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + x));
+			__m256i d = _mm256_or_si256(_mm256_or_si256(avx2_place(avx2_channel(s, sf->ir), df->ir),
+								    avx2_place(avx2_channel(s, sf->ig), df->ig)),
+						    _mm256_or_si256(avx2_place(avx2_channel(s, sf->ib), df->ib),
+								    avx2_place(avx2_channel(s, sf->ia), df->ia)));
+			_mm256_storeu_si256((__m256i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.swizzle(dst + x, dst_pitch, src + x, src_pitch, width - x, 1, df, sf);
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+AVX2 static void avx2_blend(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+			    int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf) {
+	__m256 one = _mm256_set1_ps(1.0f);
+	__m256i opaque = avx2_place(_mm256_set1_epi32(0xff), df->ia);
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8) {
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + x));
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + x));
+			__m256 cnl = _mm256_mul_ps(_mm256_cvtepi32_ps(avx2_channel(s, sf->ia)), _mm256_set1_ps(1.0f/256));
+			__m256 inv = _mm256_sub_ps(one, cnl);
+			__m256i r = avx2_mix(avx2_channel(s, sf->ir), avx2_channel(d, df->ir), cnl, inv);
+			__m256i g = avx2_mix(avx2_channel(s, sf->ig), avx2_channel(d, df->ig), cnl, inv);
+			__m256i b = avx2_mix(avx2_channel(s, sf->ib), avx2_channel(d, df->ib), cnl, inv);
+			d = _mm256_or_si256(_mm256_or_si256(avx2_place(r, df->ir), avx2_place(g, df->ig)),
+					    _mm256_or_si256(avx2_place(b, df->ib), opaque));
+			_mm256_storeu_si256((__m256i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.blend(dst + x, dst_pitch, src + x, src_pitch, width - x, 1, df, sf);
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+AVX2 static void avx2_mask_tint(uint32_t* dst, int dst_pitch, const uint8_t* mask, int mask_step, int mask_pitch,
+				int width, int height, const ei_pixel_format_t* df, ei_color_t color) {
+	__m256 one = _mm256_set1_ps(1.0f);
+	__m256i cr = _mm256_set1_epi32(color.red);
+	__m256i cg = _mm256_set1_epi32(color.green);
+	__m256i cb = _mm256_set1_epi32(color.blue);
+	__m256i opaque = avx2_place(_mm256_set1_epi32(0xff), df->ia);
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8) {
+			__m256i m;
+			if(mask_step == 1)
+				m = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(mask + x)));
+			else
+				m = _mm256_setr_epi32(mask[x * mask_step], mask[(x + 1) * mask_step],
+						      mask[(x + 2) * mask_step], mask[(x + 3) * mask_step],
+						      mask[(x + 4) * mask_step], mask[(x + 5) * mask_step],
+						      mask[(x + 6) * mask_step], mask[(x + 7) * mask_step]);
+
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + x));
+			__m256 cnl = _mm256_mul_ps(_mm256_cvtepi32_ps(m), _mm256_set1_ps(1.0f/256));
+			__m256 inv = _mm256_sub_ps(one, cnl);
+			__m256i r = avx2_mix(cr, avx2_channel(d, df->ir), cnl, inv);
+			__m256i g = avx2_mix(cg, avx2_channel(d, df->ig), cnl, inv);
+			__m256i b = avx2_mix(cb, avx2_channel(d, df->ib), cnl, inv);
+			d = _mm256_or_si256(_mm256_or_si256(avx2_place(r, df->ir), avx2_place(g, df->ig)),
+					    _mm256_or_si256(avx2_place(b, df->ib), opaque));
+			_mm256_storeu_si256((__m256i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.mask_tint(dst + x, dst_pitch, mask + x * mask_step, mask_step, mask_pitch, width - x, 1, df, color);
+		dst += dst_pitch;
+		mask += mask_pitch;
+	}
+}
+
+
+AVX2 static void avx2_blend_premul(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				   int width, int height, const ei_pixel_format_t* df, const ei_pixel_format_t* sf,
+				   ei_bool_t src_premultiplied) {
+	__m256i full = _mm256_set1_epi32(255);
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8) {
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + x));
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + x));
+			__m256i a = avx2_channel(s, sf->ia);
+			__m256i inv = _mm256_sub_epi32(full, a);
+			__m256i c[3];
+			const int si[3] = {sf->ir, sf->ig, sf->ib};
+			const int di[3] = {df->ir, df->ig, df->ib};
+			for(int i = 0; i < 3; i++) {
+				__m256i sc = avx2_channel(s, si[i]);
+				__m256i dc = avx2_mul8(avx2_channel(d, di[i]), inv);
+				if(src_premultiplied)
+					c[i] = _mm256_min_epi32(_mm256_add_epi32(sc, avx2_div255(dc)), full);
+				else
+					c[i] = avx2_div255(_mm256_add_epi32(avx2_mul8(sc, a), dc));
+			}
+			__m256i oa = _mm256_add_epi32(a, avx2_div255(avx2_mul8(avx2_channel(d, df->ia), inv)));
+			d = _mm256_or_si256(_mm256_or_si256(avx2_place(c[0], df->ir), avx2_place(c[1], df->ig)),
+					    _mm256_or_si256(avx2_place(c[2], df->ib), avx2_place(oa, df->ia)));
+			_mm256_storeu_si256((__m256i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.blend_premul(dst + x, dst_pitch, src + x, src_pitch, width - x, 1, df, sf, src_premultiplied);
+		dst += dst_pitch;
+		src += src_pitch;
+	}
+}
+
+
+AVX2 static void avx2_mask_tint_premul(uint32_t* dst, int dst_pitch, const uint8_t* mask, int mask_step, int mask_pitch,
+				       int width, int height, const ei_pixel_format_t* df, ei_color_t color) {
+	__m256i full = _mm256_set1_epi32(255);
+	__m256i ca = _mm256_set1_epi32(color.alpha);
+	__m256i cc[3] = {_mm256_set1_epi32(color.red), _mm256_set1_epi32(color.green), _mm256_set1_epi32(color.blue)};
+	const int di[3] = {df->ir, df->ig, df->ib};
+	for(int y = 0; y < height; y++) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8) {
+			__m256i m;
+			if(mask_step == 1)
+				m = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(mask + x)));
+			else
+				m = _mm256_setr_epi32(mask[x * mask_step], mask[(x + 1) * mask_step],
+						      mask[(x + 2) * mask_step], mask[(x + 3) * mask_step],
+						      mask[(x + 4) * mask_step], mask[(x + 5) * mask_step],
+						      mask[(x + 6) * mask_step], mask[(x + 7) * mask_step]);
+
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + x));
+			__m256i a = avx2_div255(avx2_mul8(m, ca));
+			__m256i inv = _mm256_sub_epi32(full, a);
+			__m256i c[3];
+			for(int i = 0; i < 3; i++)
+				c[i] = avx2_div255(_mm256_add_epi32(avx2_mul8(cc[i], a), avx2_mul8(avx2_channel(d, di[i]), inv)));
+			__m256i oa = _mm256_add_epi32(a, avx2_div255(avx2_mul8(avx2_channel(d, df->ia), inv)));
+			d = _mm256_or_si256(_mm256_or_si256(avx2_place(c[0], df->ir), avx2_place(c[1], df->ig)),
+					    _mm256_or_si256(avx2_place(c[2], df->ib), avx2_place(oa, df->ia)));
+			_mm256_storeu_si256((__m256i*)(dst + x), d);
+		}
+		if(x < width)
+			ei_kernels_scalar.mask_tint_premul(dst + x, dst_pitch, mask + x * mask_step, mask_step, mask_pitch, width - x, 1, df, color);
+		dst += dst_pitch;
+		mask += mask_pitch;
+	}
+}
+
+
+AVX2 static void avx2_scale_nearest(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				    int width, int height, const int* xs, const int* ys) {
+	for(int y = 0; y < height; y++) {
+		const int *row = (const int *)(src + ys[y] * src_pitch);
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+			_mm256_storeu_si256((__m256i*)(dst + x),
+					    _mm256_i32gather_epi32(row, _mm256_loadu_si256((const __m256i*)(xs + x)), 4));
+		for(; x < width; x++)
+			dst[x] = (uint32_t)row[xs[x]];
+		dst += dst_pitch;
+	}
+}
+
+
+/* (p0 * (256 - w) + p1 * w + 128) >> 8 for 16 channels as uint16 (the sums fit in 16 bits) */
+AVX2 static inline __m256i avx2_lerp16(__m256i p0, __m256i p1, __m256i w) {
+	__m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(256), w);
+	__m256i sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(p0, inv), _mm256_mullo_epi16(p1, w)), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(sum, 8);
+}
+
+
+AVX2 static void avx2_scale_bilinear(uint32_t* dst, int dst_pitch, const uint32_t* src, int src_pitch,
+				     int width, int height, const int* xs0, const int* xs1, const uint8_t* xw,
+				     const int* ys0, const int* ys1, const uint8_t* yw) {
+	const __m256i zero = _mm256_setzero_si256();
+	for(int y = 0; y < height; y++) {
+		const int *row0 = (const int *)(src + ys0[y] * src_pitch);
+		const int *row1 = (const int *)(src + ys1[y] * src_pitch);
+		__m256i wy = _mm256_set1_epi16(yw[y]);
+		int x = 0;
+		for(; x + 8 <= width; x += 8) {
+			__m256i i0 = _mm256_loadu_si256((const __m256i*)(xs0 + x));
+			__m256i i1 = _mm256_loadu_si256((const __m256i*)(xs1 + x));
+			__m256i p00 = _mm256_i32gather_epi32(row0, i0, 4), p01 = _mm256_i32gather_epi32(row0, i1, 4);
+			__m256i p10 = _mm256_i32gather_epi32(row1, i0, 4), p11 = _mm256_i32gather_epi32(row1, i1, 4);
+			/* the weight of each pixel in its 4 channels, unpacked like the pixels */
+			__m256i w = _mm256_mullo_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(xw + x))),
+						       _mm256_set1_epi32(0x01010101));
+			__m256i wlo = _mm256_unpacklo_epi8(w, zero), whi = _mm256_unpackhi_epi8(w, zero);
+
+			__m256i lo = avx2_lerp16(avx2_lerp16(_mm256_unpacklo_epi8(p00, zero), _mm256_unpacklo_epi8(p01, zero), wlo),
+						 avx2_lerp16(_mm256_unpacklo_epi8(p10, zero), _mm256_unpacklo_epi8(p11, zero), wlo), wy);
+			__m256i hi = avx2_lerp16(avx2_lerp16(_mm256_unpackhi_epi8(p00, zero), _mm256_unpackhi_epi8(p01, zero), whi),
+						 avx2_lerp16(_mm256_unpackhi_epi8(p10, zero), _mm256_unpackhi_epi8(p11, zero), whi), wy);
+			_mm256_storeu_si256((__m256i*)(dst + x), _mm256_packus_epi16(lo, hi));
+		}
+		if(x < width)
+			ei_kernels_scalar.scale_bilinear(dst + x, dst_pitch, src, src_pitch, width - x, 1,
+							 xs0 + x, xs1 + x, xw + x, ys0 + y, ys1 + y, yw + y);
+		dst += dst_pitch;
+	}
+}
+
+
+const ei_kernels_t ei_kernels_avx2 = {
+	"avx2",
+	avx2_fill,
+	avx2_copy,
+	avx2_swizzle,
+	avx2_blend,
+	avx2_mask_tint,
+	avx2_blend_premul,
+	avx2_mask_tint_premul,
+	avx2_scale_nearest,
+	avx2_scale_bilinear
+};
+
+#endif
@@ -0,0 +1,404 @@
+/**
+ *  @file	ei_picking.c
+ *  @brief	Finds the widget under a point of the root window, either by reading an offscreen
+ *		pick surface, a compact buffer of 16 bits ids, or geometrically by hit-testing the
+ *		shapes of the widgets.
+ *
+ */
+
+#include "ei_picking.h"
+#include "ei_application.h"
+#include "ei_buttonclass.h"
+#include "ei_toplevelclass.h"
+#include "ei_calculations.h"
+#include "ei_surface.h"
+#include "ei_geometry_store.h"
+#include "ei_geometrymanager.h"
+#include <string.h>
+
+/* Side (in pixels) of the square cells of the spatial index */
+#define PICK_CELL_SIZE 64
+/* Value of the compact pick buffer telling that the exact widget must be found geometrically:
+   the cell is shared by several widgets (half resolution), or the id does not fit in 16 bits */
+#define PICK_ID_REFINE 0xFFFF
+
+
+/* A widget registered in the spatial index */
+typedef struct ei_pick_entry_t {
+	ei_widget_t*	widget;		///< The widget.
+	ei_rect_t	rect;		///< The part of its shape's bounding box that is not clipped by its ancestors.
+} ei_pick_entry_t;
+
+
+/* offscreen filled with the pick colors (offscreen mode only) */
+static ei_surface_t pick_surface = NULL;
+/* 16 bits pick ids (compact modes only), one per cell of (1 << ids_shift) x (1 << ids_shift) pixels */
+static uint16_t *pick_ids = NULL;
+static int ids_shift = 0;
+static int ids_w = 0;
+static int ids_h = 0;
+static int ids_pitch = 0;
+/* size of the root window */
+static ei_size_t window_size;
+
+/* widgets of the spatial index, in drawing order (bottom to top) */
+static ei_pick_entry_t *entries = NULL;
+static int entries_nb = 0;
+static int entries_size = 0;
+/* for each cell, the indices of the entries overlapping it (in drawing order) */
+static int *cell_start = NULL;
+static int *cell_entries = NULL;
+static int cells_w = 0;
+static int cells_h = 0;
+/* true if the spatial index must be rebuilt before the next pick */
+static ei_bool_t index_dirty = EI_TRUE;
+
+/* widgets indexed by their pick_id, and the released ids (to keep the ids small) */
+static ei_widget_t **widgets_by_id = NULL;
+static uint32_t ids_size = 0;
+static uint32_t ids_nb = 0;
+static uint32_t *free_ids = NULL;
+static uint32_t free_ids_nb = 0;
+
+
+static ei_bool_t point_in_rect(ei_point_t where, ei_rect_t rect) {
+	return (ei_bool_t)(where.x >= rect.top_left.x && where.x < rect.top_left.x + rect.size.width &&
+			   where.y >= rect.top_left.y && where.y < rect.top_left.y + rect.size.height);
+}
+
+
+void ei_picking_init(ei_surface_t root_surface, ei_size_t size, ei_picking_mode_t mode) {
+	window_size = size;
+	index_dirty = EI_TRUE;
+
+	/* only the surface mode needs an offscreen */
+	pick_surface = NULL;
+	pick_ids = NULL;
+	if(mode == ei_picking_offscreen) {
+		pick_surface = hw_surface_create(root_surface, size, EI_FALSE);
+	} else if(mode == ei_picking_compact || mode == ei_picking_compact_half) {
+		ids_shift = (mode == ei_picking_compact_half) ? 1 : 0;
+		ids_w = (size.width + (1 << ids_shift) - 1) >> ids_shift;
+		ids_h = (size.height + (1 << ids_shift) - 1) >> ids_shift;
+		pick_ids = ei_surface_alloc_rows(ids_w, ids_h, sizeof(uint16_t), &ids_pitch);
+		memset(pick_ids, 0xFF, ids_pitch * ids_h * sizeof(uint16_t));
+	}
+
+	cells_w = (size.width + PICK_CELL_SIZE - 1) / PICK_CELL_SIZE;
+	cells_h = (size.height + PICK_CELL_SIZE - 1) / PICK_CELL_SIZE;
+}
+
+
+void ei_picking_free(void) {
+	if(pick_surface)
+		ei_surface_free(pick_surface);
+	pick_surface = NULL;
+	free(pick_ids);
+	pick_ids = NULL;
+
+	free(entries);
+	free(cell_start);
+	free(cell_entries);
+	entries = NULL;
+	cell_start = NULL;
+	cell_entries = NULL;
+	entries_nb = entries_size = 0;
+
+	free(widgets_by_id);
+	free(free_ids);
+	widgets_by_id = NULL;
+	free_ids = NULL;
+	ids_size = ids_nb = free_ids_nb = 0;
+}
+
+
+uint32_t ei_picking_register(ei_widget_t* widget) {
+	uint32_t id;
+
+	/* reuses the last released id, so that the ids stay below the number of living widgets */
+	if(free_ids_nb) {
+		id = free_ids[--free_ids_nb];
+	} else {
+		if(ids_nb == ids_size) {
+			ids_size = ids_size ? 2 * ids_size : 64;
+			widgets_by_id = realloc(widgets_by_id, ids_size * sizeof(ei_widget_t*));
+			free_ids = realloc(free_ids, ids_size * sizeof(uint32_t));
+		}
+		id = ids_nb++;
+	}
+	widgets_by_id[id] = widget;
+	return id;
+}
+
+
+void ei_picking_unregister(ei_widget_t* widget) {
+	if(widget->pick_id >= ids_nb || widgets_by_id[widget->pick_id] != widget)
+		return;
+
+	widgets_by_id[widget->pick_id] = NULL;
+	free_ids[free_ids_nb++] = widget->pick_id;
+}
+
+
+ei_widget_t* ei_picking_widget(uint32_t id) {
+	return (id < ids_nb) ? widgets_by_id[id] : NULL;
+}
+
+
+ei_surface_t ei_picking_surface(void) {
+	return pick_surface;
+}
+
+
+void ei_picking_invalidate(void) {
+	index_dirty = EI_TRUE;
+}
+
+
+/* radius of the rounded corners of a widget (0 if its shape is a rectangle) */
+static int corner_radius(ei_widget_t* widget) {
+	if(strcmp(widget->wclass->name, "button"))
+		return 0;
+
+	ei_button_t *button = (ei_button_t*)widget;
+	int r = button->corner_radius;
+	int h = min(widget->screen_location.size.width, widget->screen_location.size.height) / 2;
+	return max(min(r, h), 0);
+}
+
+
+ei_bool_t ei_picking_hit_shape(ei_widget_t* widget, ei_point_t where) {
+	/* toplevels: the decorations (title bar, borders) belong to the widget */
+	if(!strcmp(widget->wclass->name, "toplevel"))
+		return point_in_rect(where, ((ei_toplevel_t*)widget)->draw_rect);
+
+	ei_rect_t sl = widget->screen_location;
+	if(!point_in_rect(where, sl))
+		return EI_FALSE;
+
+	/* buttons: the corners are rounded */
+	int r = corner_radius(widget);
+	if(r == 0)
+		return EI_TRUE;
+
+	/* distance from the pixel center to the nearest corner center (0 outside of the corners) */
+	float cx = where.x + 0.5f;
+	float cy = where.y + 0.5f;
+	float dx = max(max(sl.top_left.x + r - cx, cx - (sl.top_left.x + sl.size.width - r)), 0);
+	float dy = max(max(sl.top_left.y + r - cy, cy - (sl.top_left.y + sl.size.height - r)), 0);
+	return (ei_bool_t)(dx * dx + dy * dy <= r * r);
+}
+
+
+static void add_entry(ei_widget_t* widget, ei_rect_t rect) {
+	if(rect.size.width <= 0 || rect.size.height <= 0)
+		return;
+
+	if(entries_nb == entries_size) {
+		entries_size = entries_size ? 2 * entries_size : 64;
+		entries = realloc(entries, entries_size * sizeof(ei_pick_entry_t));
+	}
+	entries[entries_nb].widget = widget;
+	entries[entries_nb].rect = rect;
+	entries_nb++;
+}
+
+
+static void index_children(const ei_geometry_store_t* store, int32_t slot, ei_rect_t clipper) {
+	/* same traversal as the drawing: children are drawn above their parent, in the list order */
+	if(clipper.size.width < 0 || clipper.size.height < 0)
+		return;
+
+	for(int32_t child = store->first_child[slot]; child != EI_GEOMETRY_NONE; child = store->next_sibling[child]) {
+		if((store->flags[child] & (ei_geometry_mapped | ei_geometry_hidden)) != ei_geometry_mapped)
+			continue;
+		/* the widgets moved with an ancestor since they were drawn are moved in the store */
+		ei_widget_t *widget = ei_picking_widget((uint32_t)child);
+		ei_geometrymanager_resolve(widget);
+
+		/* the close buttons of the toplevels are not clipped by the parent's content_rect */
+		ei_rect_t shape_clipper = clipper;
+		if(store->flags[child] & ei_geometry_unclipped)
+			shape_clipper = store->content[store->parent[slot]];
+
+		add_entry(widget, get_ei_rect_intersection(store->bounds[child], shape_clipper));
+		index_children(store, child, get_ei_rect_intersection(clipper, store->content[child]));
+	}
+}
+
+
+static void build_index(void) {
+	ei_widget_t *root = ei_app_root_widget();
+	int cells_nb = cells_w * cells_h;
+
+	/* lists the visible widgets in drawing order */
+	entries_nb = 0;
+	add_entry(root, *root->content_rect);
+	index_children(ei_geometry_store(), (int32_t)root->pick_id, *root->content_rect);
+
+	/* counts the entries of each cell... */
+	cell_start = realloc(cell_start, (cells_nb + 1) * sizeof(int));
+	memset(cell_start, 0, (cells_nb + 1) * sizeof(int));
+	for(int i = 0; i < entries_nb; i++) {
+		ei_rect_t r = get_ei_rect_intersection(entries[i].rect, (ei_rect_t){{0, 0}, window_size});
+		if(r.size.width <= 0 || r.size.height <= 0)
+			continue;
+		for(int cy = r.top_left.y / PICK_CELL_SIZE; cy <= (r.top_left.y + r.size.height - 1) / PICK_CELL_SIZE; cy++)
+			for(int cx = r.top_left.x / PICK_CELL_SIZE; cx <= (r.top_left.x + r.size.width - 1) / PICK_CELL_SIZE; cx++)
+				cell_start[cy * cells_w + cx + 1]++;
+	}
+	for(int c = 0; c < cells_nb; c++)
+		cell_start[c + 1] += cell_start[c];
+
+	/* ... then fills them, keeping the drawing order */
+	cell_entries = realloc(cell_entries, (cell_start[cells_nb] + 1) * sizeof(int));
+	int *fill = calloc(cells_nb + 1, sizeof(int));
+	for(int i = 0; i < entries_nb; i++) {
+		ei_rect_t r = get_ei_rect_intersection(entries[i].rect, (ei_rect_t){{0, 0}, window_size});
+		if(r.size.width <= 0 || r.size.height <= 0)
+			continue;
+		for(int cy = r.top_left.y / PICK_CELL_SIZE; cy <= (r.top_left.y + r.size.height - 1) / PICK_CELL_SIZE; cy++)
+			for(int cx = r.top_left.x / PICK_CELL_SIZE; cx <= (r.top_left.x + r.size.width - 1) / PICK_CELL_SIZE; cx++) {
+				int c = cy * cells_w + cx;
+				cell_entries[cell_start[c] + fill[c]++] = i;
+			}
+	}
+	free(fill);
+
+	index_dirty = EI_FALSE;
+}
+
+
+static ei_widget_t* find_geometric(ei_point_t where) {
+	if(index_dirty)
+		build_index();
+
+	/* walks the cell's entries from top to bottom */
+	int c = (where.y / PICK_CELL_SIZE) * cells_w + where.x / PICK_CELL_SIZE;
+	for(int i = cell_start[c + 1] - 1; i >= cell_start[c]; i--) {
+		ei_pick_entry_t *entry = &entries[cell_entries[i]];
+		if(point_in_rect(where, entry->rect) && ei_picking_hit_shape(entry->widget, where))
+			return entry->widget;
+	}
+	return NULL;
+}
+
+
+/* tells if a pixel of an entry is covered by its widget */
+static ei_bool_t entry_covers(ei_pick_entry_t* entry, int r, int x, int y) {
+	if(!point_in_rect((ei_point_t){x, y}, entry->rect))
+		return EI_FALSE;
+
+	/* the exact shape is only needed in the corners */
+	ei_rect_t sl = entry->widget->screen_location;
+	if(r && (x < sl.top_left.x + r || x >= sl.top_left.x + sl.size.width - r) &&
+		(y < sl.top_left.y + r || y >= sl.top_left.y + sl.size.height - r))
+		return ei_picking_hit_shape(entry->widget, (ei_point_t){x, y});
+	return EI_TRUE;
+}
+
+
+static void paint_entry(ei_pick_entry_t* entry, int cx0, int cy0, int cx1, int cy1) {
+	int size = 1 << ids_shift;
+	int r = corner_radius(entry->widget);
+	uint16_t id = (entry->widget->pick_id < PICK_ID_REFINE) ? (uint16_t)entry->widget->pick_id : PICK_ID_REFINE;
+
+	/* restricts the cells to the ones overlapping the entry */
+	ei_rect_t er = entry->rect;
+	cx0 = max(cx0, er.top_left.x >> ids_shift);
+	cy0 = max(cy0, er.top_left.y >> ids_shift);
+	cx1 = min(cx1, (er.top_left.x + er.size.width - 1) >> ids_shift);
+	cy1 = min(cy1, (er.top_left.y + er.size.height - 1) >> ids_shift);
+
+	for(int cy = cy0; cy <= cy1; cy++) {
+		uint16_t *cell = pick_ids + cy * ids_pitch + cx0;
+		for(int cx = cx0; cx <= cx1; cx++, cell++) {
+			/* counts the pixels of the cell (inside the window) covered by the widget */
+			int covered = 0, total = 0;
+			for(int y = cy << ids_shift; y < (cy << ids_shift) + size && y < window_size.height; y++)
+				for(int x = cx << ids_shift; x < (cx << ids_shift) + size && x < window_size.width; x++) {
+					total++;
+					covered += entry_covers(entry, r, x, y);
+				}
+
+			if(covered == total)
+				*cell = id;
+			else if(covered)
+				*cell = PICK_ID_REFINE;
+		}
+	}
+}
+
+
+void ei_picking_update(const ei_linked_rect_t* rects) {
+	if(!pick_ids)
+		return;
+
+	if(index_dirty)
+		build_index();
+
+	ei_linked_rect_t all = {{{0, 0}, window_size}, NULL};
+	if(!rects)
+		rects = &all;
+
+	/* paints the widgets overlapping each rectangle, from bottom to top */
+	for(; rects; rects = rects->next) {
+		ei_rect_t rect = get_ei_rect_intersection(rects->rect, all.rect);
+		if(rect.size.width <= 0 || rect.size.height <= 0)
+			continue;
+
+		int cx0 = rect.top_left.x >> ids_shift;
+		int cy0 = rect.top_left.y >> ids_shift;
+		int cx1 = (rect.top_left.x + rect.size.width - 1) >> ids_shift;
+		int cy1 = (rect.top_left.y + rect.size.height - 1) >> ids_shift;
+		ei_rect_t cells_rect = {{cx0 << ids_shift, cy0 << ids_shift},
+					{(cx1 - cx0 + 1) << ids_shift, (cy1 - cy0 + 1) << ids_shift}};
+
+		for(int i = 0; i < entries_nb; i++) {
+			ei_rect_t inter = get_ei_rect_intersection(entries[i].rect, cells_rect);
+			if(inter.size.width > 0 && inter.size.height > 0)
+				paint_entry(&entries[i], cx0, cy0, cx1, cy1);
+		}
+	}
+}
+
+
+static ei_widget_t* find_compact(ei_point_t where) {
+	uint16_t id = pick_ids[(where.y >> ids_shift) * ids_pitch + (where.x >> ids_shift)];
+
+	/* cell shared by several widgets: exact refinement */
+	if(id == PICK_ID_REFINE)
+		return find_geometric(where);
+
+	return ei_picking_widget(id);
+}
+
+
+static ei_widget_t* find_by_pick_color(ei_point_t where) {
+	ei_surface_desc_t desc = ei_surface_desc(pick_surface);
+	uint32_t pixel = *EI_PIXEL_AT(&desc, where.x, where.y);
+
+	/* decodes the pick color (see ei_widget_create) */
+	const ei_pixel_format_t *f = desc.format;
+	uint32_t id = ((pixel >> (8 * f->ir)) & 255) |
+		      (((pixel >> (8 * f->ig)) & 255) << 8) |
+		      (((pixel >> (8 * f->ib)) & 255) << 16);
+	return ei_picking_widget(id);
+}
+
+
+ei_widget_t* ei_picking_find(ei_point_t where) {
+	if(!point_in_rect(where, (ei_rect_t){{0, 0}, window_size}))
+		return NULL;
+
+	if(pick_surface)
+		return find_by_pick_color(where);
+	if(pick_ids)
+		return find_compact(where);
+	return find_geometric(where);
+}
+
+
+ei_bool_t ei_picking_is_under(ei_widget_t* widget, ei_point_t where) {
+	return (ei_bool_t)(widget && ei_picking_find(where) == widget);
+}
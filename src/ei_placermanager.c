@@ -6,13 +6,23 @@
 
 #include "ei_placermanager.h"
 #include "ei_calculations.h"
+#include "ei_geometry_store.h"
+#include "ei_batch.h"
 
 void runplacer(struct ei_widget_t* widget) {
     /* returns if the widget does not exist or if it is not managed by a placer */
     if(!widget || !(widget->geom_params) || strcmp(widget->geom_params->manager->name, "placer"))
         return;
+    /* inside a batch, the widget is laid out once at the commit */
+    if(ei_batch_defer_layout(widget))
+        return;
     
+    /* the place is computed from the content of the parent, which may have moved */
+    ei_geometrymanager_resolve(widget->parent);
     ei_rect_t old_screen_location = widget->screen_location;
+    /* where it was drawn: its screen_location may not have followed its ancestors yet, and a
+       toplevel covers more than its screen_location */
+    ei_rect_t old_bounds = ei_geometry_store()->bounds[widget->pick_id];
 
     /* Reocurring variables */ 
     ei_rect_t parent_sl = *widget->parent->content_rect;
@@ -70,12 +80,19 @@ void runplacer(struct ei_widget_t* widget) {
     widget->screen_location.top_left = (ei_point_t) {x, y};
     widget->screen_location.size =  (ei_size_t) {width, height};
 
+    /* the descendants are moved with the widget when they are resolved */
+    widget->relative_position = (ei_point_t) {x - parent_sl.top_left.x, y - parent_sl.top_left.y};
+    widget->parent_size = parent_sl.size;
+    widget->parent_version = widget->parent->geom_version;
+
     if( widget->screen_location.top_left.x != old_screen_location.top_left.x ||
         widget->screen_location.top_left.y != old_screen_location.top_left.y ||
         widget->screen_location.size.width != old_screen_location.size.width ||
         widget->screen_location.size.height != old_screen_location.size.height) {
-            ei_rect_t inv_rect = extend_rect(old_screen_location);
+            ei_rect_t inv_rect = extend_rect(old_bounds);
             ei_app_invalidate_rect(&inv_rect);
+            widget->geom_version++;
             widget->wclass->geomnotifyfunc(widget);
     }
+    ei_geometry_store_update(widget);
 }
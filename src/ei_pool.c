@@ -0,0 +1,107 @@
+/**
+ *  @file	ei_pool.c
+ *  @brief	Pool of reusable pixel buffers, for the temporary buffers of the library. The
+ *		buffers are bucketed by size (powers of 2), and the free ones are kept up to a
+ *		byte cap.
+ *
+ */
+
+#include "ei_pool.h"
+#include "ei_surface.h"
+#include <stdlib.h>
+
+/* the smallest bucket holds buffers of 1 << POOL_MIN_SHIFT bytes */
+#define POOL_MIN_SHIFT	6
+#define POOL_BUCKETS	48
+
+
+/* Header of a buffer, stored EI_ROW_ALIGN bytes before its pixels to keep them aligned */
+typedef struct ei_pool_block_t {
+	struct ei_pool_block_t*	next;		///< Next free block of the same bucket.
+	int			bucket;		///< The block holds 1 << bucket bytes.
+} ei_pool_block_t;
+
+
+/* free blocks of each bucket */
+static ei_pool_block_t *free_blocks[POOL_BUCKETS];
+static ei_pool_stats_t stats = {0, 0, 0, EI_POOL_DEFAULT_CAP};
+
+
+static int bucket_of(size_t bytes) {
+	int bucket = POOL_MIN_SHIFT;
+	while(((size_t)1 << bucket) < bytes)
+		bucket++;
+	return bucket;
+}
+
+
+/* frees free blocks, from the biggest ones, until the retained bytes fit in the cap */
+static void trim(void) {
+	for(int b = POOL_BUCKETS - 1; b >= 0 && stats.bytes_retained > stats.bytes_cap; b--) {
+		while(free_blocks[b] && stats.bytes_retained > stats.bytes_cap) {
+			ei_pool_block_t *block = free_blocks[b];
+			free_blocks[b] = block->next;
+			stats.bytes_retained -= (size_t)1 << b;
+			free(block);
+		}
+	}
+}
+
+
+void* ei_pool_get(int width, int height, int pixel_size, int* pitch) {
+	int row = (width * pixel_size + EI_ROW_ALIGN - 1) & ~(EI_ROW_ALIGN - 1);
+	*pitch = row / pixel_size;
+	int bucket = bucket_of((size_t)row * (height > 0 ? height : 1));
+	if(bucket >= POOL_BUCKETS)
+		return NULL;
+
+	ei_pool_block_t *block = free_blocks[bucket];
+	if(block) {
+		free_blocks[bucket] = block->next;
+		stats.bytes_retained -= (size_t)1 << bucket;
+		stats.hits++;
+	} else {
+		void *memory;
+		if(posix_memalign(&memory, EI_ROW_ALIGN, EI_ROW_ALIGN + ((size_t)1 << bucket)) != 0)
+			return NULL;
+		block = memory;
+		block->bucket = bucket;
+		stats.misses++;
+	}
+	return (char *)block + EI_ROW_ALIGN;
+}
+
+
+void ei_pool_put(void* buffer) {
+	if(!buffer)
+		return;
+
+	ei_pool_block_t *block = (ei_pool_block_t *)((char *)buffer - EI_ROW_ALIGN);
+	size_t bytes = (size_t)1 << block->bucket;
+	if(stats.bytes_retained + bytes > stats.bytes_cap) {
+		free(block);
+		return;
+	}
+	block->next = free_blocks[block->bucket];
+	free_blocks[block->bucket] = block;
+	stats.bytes_retained += bytes;
+}
+
+
+void ei_pool_set_cap(size_t bytes) {
+	stats.bytes_cap = bytes;
+	trim();
+}
+
+
+ei_pool_stats_t ei_pool_get_stats(void) {
+	return stats;
+}
+
+
+void ei_pool_free(void) {
+	size_t cap = stats.bytes_cap;
+	stats.bytes_cap = 0;
+	trim();
+	stats.bytes_cap = cap;
+}
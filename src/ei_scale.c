@@ -0,0 +1,271 @@
+/**
+ *  @file	ei_scale.c
+ *  @brief	Scaling of images (nearest neighbour or bilinear), stretched or in nine slices, and
+ *		cache of the scaled images of the widgets, kept for each target size.
+ *
+ */
+
+#include "ei_scale.h"
+#include "ei_kernels.h"
+#include "ei_calculations.h"
+#include "ei_pool.h"
+#include <stdlib.h>
+
+
+/* A scaled image */
+typedef struct ei_scaled_entry_t {
+	ei_surface_t			surface;	///< The surface of the view (key).
+	ei_rect_t			rect;		///< The rect of the view (key).
+	ei_size_t			size;		///< The target size (key).
+	ei_image_scaling_t		scaling;	///< The scaling (key).
+	ei_surface_desc_t		desc;		///< The scaled image, in a buffer of the pool.
+	size_t				bytes;		///< Size of the buffer.
+	struct ei_scaled_entry_t*	newer;		///< Entry used just after this one.
+	struct ei_scaled_entry_t*	older;		///< Entry used just before this one.
+} ei_scaled_entry_t;
+
+
+/* the entries, from the most recently used to the least recently used */
+static ei_scaled_entry_t *newest = NULL;
+static ei_scaled_entry_t *oldest = NULL;
+static int entries_nb = 0;
+static size_t bytes_retained = 0;
+static size_t bytes_cap = EI_SCALE_CACHE_DEFAULT_CAP;
+
+
+/* source position of the center of each destination position [d0, d1) of a length dn, in a
+   source length sn starting at s0 */
+static void map_nearest(int* s, int s0, int sn, int dn, int d0, int d1) {
+	for(int i = d0; i < d1; i++) {
+		int p = (int)((int64_t)(2 * i + 1) * sn / (2 * dn));
+		s[i - d0] = s0 + (p < sn ? p : sn - 1);
+	}
+}
+
+
+/* same as map_nearest, as the two nearest source positions and the weight of the second one
+   (8 bits fixed point) */
+static void map_bilinear(int* s0v, int* s1v, uint8_t* w, int s0, int sn, int dn, int d0, int d1) {
+	for(int i = d0; i < d1; i++) {
+		int64_t p = (int64_t)(2 * i + 1) * sn * 256 / (2 * dn) - 128;
+		int i0 = p < 0 ? 0 : (int)(p >> 8);
+		int f = p < 0 ? 0 : (int)(p & 255);
+		if(i0 >= sn - 1) {
+			i0 = sn - 1;
+			f = 0;
+		}
+		s0v[i - d0] = s0 + i0;
+		s1v[i - d0] = s0 + (f ? i0 + 1 : i0);
+		w[i - d0] = (uint8_t)f;
+	}
+}
+
+
+void ei_scale_desc(const ei_surface_desc_t* dst, const ei_rect_t* dst_rect, const ei_surface_desc_t* src,
+		   const ei_rect_t* src_rect, ei_filter_t filter, const ei_rect_t* clipper) {
+	ei_rect_t clip = get_ei_rect_intersection(*dst_rect, (ei_rect_t){{0, 0}, dst->size});
+	if(clipper)
+		clip = get_ei_rect_intersection(clip, *clipper);
+	if(clip.size.width <= 0 || clip.size.height <= 0 || src_rect->size.width <= 0 || src_rect->size.height <= 0)
+		return;
+
+	const int w = clip.size.width;
+	const int h = clip.size.height;
+	/* positions of the clipped block in dst_rect */
+	const int x0 = clip.top_left.x - dst_rect->top_left.x;
+	const int y0 = clip.top_left.y - dst_rect->top_left.y;
+	uint32_t *dst_ptr = EI_PIXEL_AT(dst, clip.top_left.x, clip.top_left.y);
+
+	if(filter == ei_filter_nearest) {
+		int *xs = malloc((size_t)(w + h) * sizeof(int));
+		int *ys = xs + w;
+		map_nearest(xs, src_rect->top_left.x, src_rect->size.width, dst_rect->size.width, x0, x0 + w);
+		map_nearest(ys, src_rect->top_left.y, src_rect->size.height, dst_rect->size.height, y0, y0 + h);
+		ei_kernels()->scale_nearest(dst_ptr, dst->pitch, src->pixels, src->pitch, w, h, xs, ys);
+		free(xs);
+	} else {
+		int *xs0 = malloc((size_t)(w + h) * (2 * sizeof(int) + 1));
+		int *xs1 = xs0 + w;
+		int *ys0 = xs1 + w;
+		int *ys1 = ys0 + h;
+		uint8_t *xw = (uint8_t *)(ys1 + h);
+		uint8_t *yw = xw + w;
+		map_bilinear(xs0, xs1, xw, src_rect->top_left.x, src_rect->size.width, dst_rect->size.width, x0, x0 + w);
+		map_bilinear(ys0, ys1, yw, src_rect->top_left.y, src_rect->size.height, dst_rect->size.height, y0, y0 + h);
+		ei_kernels()->scale_bilinear(dst_ptr, dst->pitch, src->pixels, src->pitch, w, h, xs0, xs1, xw, ys0, ys1, yw);
+		free(xs0);
+	}
+}
+
+
+/* splits a length n in 3 parts: the insets a and b, shrunk proportionally if they don't fit */
+static void split(int n, int a, int b, int* bounds) {
+	a = a < 0 ? 0 : a;
+	b = b < 0 ? 0 : b;
+	if(a + b > n) {
+		int na = (int)((int64_t)a * n / (a + b));
+		b = n - na;
+		a = na;
+	}
+	bounds[0] = 0;
+	bounds[1] = a;
+	bounds[2] = n - b;
+	bounds[3] = n;
+}
+
+
+/* scales the source in 9 slices: the corners are copied, the edges and the center are scaled */
+static void scale_nine_slice(const ei_surface_desc_t* dst, const ei_surface_desc_t* src, const ei_image_scaling_t* scaling) {
+	int sx[4], sy[4], dx[4], dy[4];
+	split(src->size.width, scaling->slices[0], scaling->slices[2], sx);
+	split(src->size.height, scaling->slices[1], scaling->slices[3], sy);
+	split(dst->size.width, sx[1], sx[3] - sx[2], dx);
+	split(dst->size.height, sy[1], sy[3] - sy[2], dy);
+
+	/* the center of the source, replaced by the column (or row) next to it if it is empty */
+	int cx[2] = {sx[1], sx[2]}, cy[2] = {sy[1], sy[2]};
+	if(cx[1] <= cx[0]) {
+		cx[0] = cx[0] < src->size.width ? cx[0] : src->size.width - 1;
+		cx[1] = cx[0] + 1;
+	}
+	if(cy[1] <= cy[0]) {
+		cy[0] = cy[0] < src->size.height ? cy[0] : src->size.height - 1;
+		cy[1] = cy[0] + 1;
+	}
+
+	for(int j = 0; j < 3; j++) {
+		const int y0 = j == 1 ? cy[0] : sy[j];
+		const int y1 = j == 1 ? cy[1] : sy[j + 1];
+		for(int i = 0; i < 3; i++) {
+			const int x0 = i == 1 ? cx[0] : sx[i];
+			const int x1 = i == 1 ? cx[1] : sx[i + 1];
+			const ei_rect_t src_rect = {{x0, y0}, {x1 - x0, y1 - y0}};
+			const ei_rect_t dst_rect = {{dx[i], dy[j]}, {dx[i + 1] - dx[i], dy[j + 1] - dy[j]}};
+			ei_scale_desc(dst, &dst_rect, src, &src_rect, scaling->filter, NULL);
+		}
+	}
+}
+
+
+static void unlink_lru(ei_scaled_entry_t* entry) {
+	if(entry->newer)
+		entry->newer->older = entry->older;
+	else
+		newest = entry->older;
+	if(entry->older)
+		entry->older->newer = entry->newer;
+	else
+		oldest = entry->newer;
+}
+
+
+static void link_newest(ei_scaled_entry_t* entry) {
+	entry->newer = NULL;
+	entry->older = newest;
+	if(newest)
+		newest->newer = entry;
+	else
+		oldest = entry;
+	newest = entry;
+}
+
+
+static void remove_entry(ei_scaled_entry_t* entry) {
+	unlink_lru(entry);
+	entries_nb--;
+	bytes_retained -= entry->bytes;
+	ei_pool_put(entry->desc.pixels);
+	free(entry);
+}
+
+
+/* evicts the least recently used entries over the caps, except keep */
+static void evict(const ei_scaled_entry_t* keep) {
+	while(oldest && oldest != keep && (entries_nb > EI_SCALE_CACHE_ENTRIES || bytes_retained > bytes_cap))
+		remove_entry(oldest);
+}
+
+
+static ei_bool_t same_key(const ei_scaled_entry_t* entry, const ei_surface_view_t* view, ei_size_t size,
+			  const ei_image_scaling_t* scaling) {
+	if(entry->surface != view->surface || entry->size.width != size.width || entry->size.height != size.height)
+		return EI_FALSE;
+	if(entry->rect.top_left.x != view->rect.top_left.x || entry->rect.top_left.y != view->rect.top_left.y ||
+	   entry->rect.size.width != view->rect.size.width || entry->rect.size.height != view->rect.size.height)
+		return EI_FALSE;
+	if(entry->scaling.mode != scaling->mode || entry->scaling.filter != scaling->filter)
+		return EI_FALSE;
+	if(scaling->mode == ei_image_nine_slice)
+		for(int i = 0; i < 4; i++)
+			if(entry->scaling.slices[i] != scaling->slices[i])
+				return EI_FALSE;
+	return EI_TRUE;
+}
+
+
+const ei_surface_desc_t* ei_scale_cache_get(const ei_surface_view_t* view, ei_size_t size, const ei_image_scaling_t* scaling) {
+	for(ei_scaled_entry_t *entry = newest; entry; entry = entry->older) {
+		if(same_key(entry, view, size, scaling)) {
+			/* becomes the most recently used */
+			unlink_lru(entry);
+			link_newest(entry);
+			return &entry->desc;
+		}
+	}
+
+	if(size.width <= 0 || size.height <= 0 || view->rect.size.width <= 0 || view->rect.size.height <= 0)
+		return NULL;
+
+	/* first drawing at this size */
+	const ei_surface_desc_t src = ei_surface_view_desc(view);
+	ei_scaled_entry_t *entry = calloc(1, sizeof(ei_scaled_entry_t));
+	entry->desc.pixels = ei_pool_get(size.width, size.height, 4, &entry->desc.pitch);
+	if(!entry->desc.pixels) {
+		free(entry);
+		return NULL;
+	}
+	entry->desc.size = size;
+	entry->desc.format = src.format;
+	entry->bytes = (size_t)entry->desc.pitch * size.height * 4;
+	if(scaling->mode == ei_image_nine_slice)
+		scale_nine_slice(&entry->desc, &src, scaling);
+	else {
+		const ei_rect_t dst_rect = {{0, 0}, size};
+		const ei_rect_t src_rect = {{0, 0}, src.size};
+		ei_scale_desc(&entry->desc, &dst_rect, &src, &src_rect, scaling->filter, NULL);
+	}
+
+	entry->surface = view->surface;
+	entry->rect = view->rect;
+	entry->size = size;
+	entry->scaling = *scaling;
+	link_newest(entry);
+	entries_nb++;
+	bytes_retained += entry->bytes;
+
+	evict(entry);
+	return &entry->desc;
+}
+
+
+void ei_scale_cache_set_cap(size_t bytes) {
+	bytes_cap = bytes;
+	evict(NULL);
+}
+
+
+void ei_scale_cache_forget(ei_surface_t surface) {
+	ei_scaled_entry_t *entry = newest;
+	while(entry) {
+		ei_scaled_entry_t *older = entry->older;
+		if(entry->surface == surface)
+			remove_entry(entry);
+		entry = older;
+	}
+}
+
+
+void ei_scale_cache_free(void) {
+	while(oldest)
+		remove_entry(oldest);
+}
@@ -0,0 +1,181 @@
+/**
+ *  @file	ei_slab.c
+ *  @brief	Slab allocators of the widgets: the widgets of a class are allocated in chunks of
+ *		memory holding several of them, and the chunks are released at once when the
+ *		toplevel owning them (or the application) is destroyed.
+ *
+ */
+
+#include "ei_slab.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* alignment of the widgets in the chunks */
+#define SLAB_ALIGN	16
+
+
+/* A class allocated in slabs (side table of the classes, keyed by their pointer) */
+typedef struct ei_slab_class_t {
+	ei_widgetclass_t*		wclass;		///< The class (key).
+	size_t				size;		///< The size of a widget, rounded up to SLAB_ALIGN.
+	struct ei_slab_class_t*		next;		///< Next registered class.
+} ei_slab_class_t;
+
+
+/* Header of a chunk, stored SLAB_ALIGN bytes before its first widget */
+typedef struct ei_slab_chunk_t {
+	struct ei_slab_chunk_t*		next;		///< Next chunk of the slab.
+} ei_slab_chunk_t;
+
+
+/* A free block of a slab, chained in its free list */
+typedef struct ei_slab_block_t {
+	struct ei_slab_block_t*		next;		///< Next free block.
+} ei_slab_block_t;
+
+
+/* The widgets of a class in an arena */
+typedef struct ei_slab_t {
+	ei_widgetclass_t*		wclass;		///< The class of the widgets.
+	size_t				size;		///< The size of a block.
+	ei_slab_chunk_t*		chunks;		///< The chunks, from the newest one.
+	int				chunk_widgets;	///< Number of blocks of the newest chunk.
+	char*				unused;		///< First block never used of the newest chunk.
+	int				unused_nb;	///< Number of blocks never used of the newest chunk.
+	ei_slab_block_t*		free_blocks;	///< Blocks of destroyed widgets.
+	struct ei_slab_t*		next;		///< Next slab of the arena.
+} ei_slab_t;
+
+
+struct ei_slab_arena_t {
+	ei_slab_t*			slabs;		///< One slab by class used in the arena.
+};
+
+
+static ei_slab_class_t *classes = NULL;
+static ei_slab_arena_t app_arena = {NULL};
+
+
+void ei_slab_register(ei_widgetclass_t* wclass, size_t widget_size) {
+	if(!wclass)
+		return;
+	for(ei_slab_class_t *registered = classes; registered; registered = registered->next)
+		if(registered->wclass == wclass)
+			return;
+
+	ei_slab_class_t *registered = malloc(sizeof(ei_slab_class_t));
+	registered->wclass = wclass;
+	registered->size = (widget_size + SLAB_ALIGN - 1) & ~(size_t)(SLAB_ALIGN - 1);
+	registered->next = classes;
+	classes = registered;
+}
+
+
+ei_slab_arena_t* ei_slab_arena_create(void) {
+	return calloc(1, sizeof(ei_slab_arena_t));
+}
+
+
+static ei_slab_t* slab_of(ei_slab_arena_t* arena, ei_widgetclass_t* wclass) {
+	for(ei_slab_t *slab = arena->slabs; slab; slab = slab->next)
+		if(slab->wclass == wclass)
+			return slab;
+
+	/* first widget of the class in the arena */
+	ei_slab_class_t *registered = classes;
+	while(registered && registered->wclass != wclass)
+		registered = registered->next;
+	if(!registered)
+		return NULL;
+	ei_slab_t *slab = calloc(1, sizeof(ei_slab_t));
+	slab->wclass = wclass;
+	slab->size = registered->size;
+	slab->next = arena->slabs;
+	arena->slabs = slab;
+	return slab;
+}
+
+
+static void* slab_get(ei_slab_t* slab) {
+	if(slab->free_blocks) {
+		ei_slab_block_t *block = slab->free_blocks;
+		slab->free_blocks = block->next;
+		return block;
+	}
+	if(!slab->unused_nb) {
+		/* the chunks grow with the slab, so that a toplevel with a few widgets stays small */
+		int widgets = slab->chunks ? 2 * slab->chunk_widgets : EI_SLAB_MIN_CHUNK_WIDGETS;
+		if(widgets > EI_SLAB_MAX_CHUNK_WIDGETS)
+			widgets = EI_SLAB_MAX_CHUNK_WIDGETS;
+		ei_slab_chunk_t *chunk = malloc(SLAB_ALIGN + (size_t)widgets * slab->size);
+		if(!chunk)
+			return NULL;
+		chunk->next = slab->chunks;
+		slab->chunks = chunk;
+		slab->chunk_widgets = widgets;
+		slab->unused = (char *)chunk + SLAB_ALIGN;
+		slab->unused_nb = widgets;
+	}
+	void *block = slab->unused;
+	slab->unused += slab->size;
+	slab->unused_nb--;
+	return block;
+}
+
+
+ei_widget_t* ei_slab_alloc(ei_slab_arena_t* arena, ei_widgetclass_t* wclass) {
+	ei_slab_t *slab = slab_of(arena ? arena : &app_arena, wclass);
+	if(!slab)
+		return wclass->allocfunc();
+
+	ei_widget_t *widget = slab_get(slab);
+	if(!widget)
+		return NULL;
+	memset(widget, 0, slab->size);
+	widget->slab = slab;
+	return widget;
+}
+
+
+void ei_slab_free(ei_widget_t* widget) {
+	ei_slab_t *slab = widget->slab;
+	if(!slab) {
+		free(widget);
+		return;
+	}
+	ei_slab_block_t *block = (ei_slab_block_t *)widget;
+	block->next = slab->free_blocks;
+	slab->free_blocks = block;
+}
+
+
+static void free_slabs(ei_slab_arena_t* arena) {
+	while(arena->slabs) {
+		ei_slab_t *slab = arena->slabs;
+		arena->slabs = slab->next;
+		while(slab->chunks) {
+			ei_slab_chunk_t *chunk = slab->chunks;
+			slab->chunks = chunk->next;
+			free(chunk);
+		}
+		free(slab);
+	}
+}
+
+
+void ei_slab_arena_free(ei_slab_arena_t* arena) {
+	if(!arena)
+		return;
+	free_slabs(arena);
+	free(arena);
+}
+
+
+void ei_slab_free_all(void) {
+	free_slabs(&app_arena);
+	while(classes) {
+		ei_slab_class_t *registered = classes;
+		classes = registered->next;
+		free(registered);
+	}
+}
@@ -0,0 +1,215 @@
+/**
+ *  @file	ei_surface.c
+ *  @brief	Information kept by the library about the surfaces: pixel format (cached on first
+ *		use), premultiplied alpha, reference count, row stride, opacity. Views on a part of a
+ *		surface, and descriptors used by the drawing code to address the pixels.
+ *
+ */
+
+#include "ei_surface.h"
+#include "ei_kernels.h"
+#include "ei_scale.h"
+#include <stdlib.h>
+
+/* Number of buckets of the surface table (power of 2) */
+#define SURFACE_BUCKETS 256
+
+
+/* What the library knows about a surface */
+typedef struct ei_surface_info_t {
+	ei_surface_t			surface;	///< The surface (key).
+	ei_pixel_format_t		format;		///< Its pixel format.
+	int				refcount;	///< Number of references (1 for the owner).
+	int				pitch;		///< Distance between two rows in pixels, 0 if it is the width.
+	ei_bool_t			opacity_known;	///< EI_TRUE if opaque and visible are set.
+	ei_bool_t			opaque;		///< EI_TRUE if all the pixels are opaque.
+	ei_rect_t			visible;	///< Bounding box of the pixels which are not fully transparent.
+	struct ei_surface_info_t*	next;		///< Next info of the same bucket.
+} ei_surface_info_t;
+
+
+/* hash table of the known surfaces */
+static ei_surface_info_t *buckets[SURFACE_BUCKETS];
+
+
+static unsigned bucket_of(ei_surface_t surface) {
+	uintptr_t key = (uintptr_t)surface;
+	/* the low bits of a pointer are always 0 */
+	return (unsigned)((key >> 4) ^ (key >> 12)) & (SURFACE_BUCKETS - 1);
+}
+
+
+static ei_pixel_order_t order_of(const ei_pixel_format_t* f) {
+	if(f->ia == -1)
+		return ei_pixel_order_other;
+	if(f->ir == 0 && f->ig == 1 && f->ib == 2 && f->ia == 3)
+		return ei_pixel_order_rgba;
+	if(f->ir == 2 && f->ig == 1 && f->ib == 0 && f->ia == 3)
+		return ei_pixel_order_bgra;
+	if(f->ir == 1 && f->ig == 2 && f->ib == 3 && f->ia == 0)
+		return ei_pixel_order_argb;
+	if(f->ir == 3 && f->ig == 2 && f->ib == 1 && f->ia == 0)
+		return ei_pixel_order_abgr;
+	return ei_pixel_order_other;
+}
+
+
+static ei_surface_info_t* get_info(ei_surface_t surface) {
+	unsigned b = bucket_of(surface);
+	for(ei_surface_info_t *info = buckets[b]; info; info = info->next)
+		if(info->surface == surface)
+			return info;
+
+	/* first use of this surface */
+	ei_surface_info_t *info = calloc(1, sizeof(ei_surface_info_t));
+	info->surface = surface;
+	info->refcount = 1;
+	hw_surface_get_channel_indices(surface, &info->format.ir, &info->format.ig, &info->format.ib, &info->format.ia);
+	info->format.order = order_of(&info->format);
+
+	info->next = buckets[b];
+	buckets[b] = info;
+	return info;
+}
+
+
+const ei_pixel_format_t* ei_surface_format(ei_surface_t surface) {
+	return &get_info(surface)->format;
+}
+
+
+void ei_surface_set_premultiplied(ei_surface_t surface, ei_bool_t premultiplied) {
+	get_info(surface)->format.premultiplied = premultiplied;
+}
+
+
+void ei_surface_premultiply(ei_surface_t surface) {
+	ei_pixel_format_t *f = &get_info(surface)->format;
+	if(f->premultiplied || f->ia < 0)
+		return;
+
+	hw_surface_lock(surface);
+	ei_surface_desc_t desc = ei_surface_desc(surface);
+	for(int y = 0; y < desc.size.height; y++) {
+		uint32_t *pixel_ptr = EI_PIXEL_AT(&desc, 0, y);
+		for(int x = 0; x < desc.size.width; x++) {
+			uint32_t p = pixel_ptr[x];
+			uint32_t a = EI_CHANNEL(p, f->ia);
+			pixel_ptr[x] = EI_PACK(EI_DIV255(EI_CHANNEL(p, f->ir) * a), EI_DIV255(EI_CHANNEL(p, f->ig) * a),
+					       EI_DIV255(EI_CHANNEL(p, f->ib) * a), a, f->ir, f->ig, f->ib, f->ia);
+		}
+	}
+	hw_surface_unlock(surface);
+
+	f->premultiplied = EI_TRUE;
+}
+
+
+void ei_surface_set_opacity(ei_surface_t surface, ei_bool_t opaque, const ei_rect_t* visible) {
+	ei_surface_info_t *info = get_info(surface);
+	info->opacity_known = EI_TRUE;
+	info->opaque = opaque;
+	info->visible = *visible;
+}
+
+
+ei_bool_t ei_surface_get_opacity(ei_surface_t surface, ei_bool_t* opaque, ei_rect_t* visible) {
+	ei_surface_info_t *info = get_info(surface);
+	if(!info->opacity_known)
+		return EI_FALSE;
+	*opaque = info->opaque;
+	*visible = info->visible;
+	return EI_TRUE;
+}
+
+
+void ei_surface_retain(ei_surface_t surface) {
+	get_info(surface)->refcount++;
+}
+
+
+void ei_surface_release(ei_surface_t surface) {
+	if(--get_info(surface)->refcount <= 0)
+		ei_surface_free(surface);
+}
+
+
+ei_surface_view_t ei_surface_view(ei_surface_t surface, const ei_rect_t* rect) {
+	ei_size_t size = hw_surface_get_size(surface);
+	ei_surface_view_t view = {surface, {{0, 0}, size}};
+	if(rect) {
+		/* clips the rect to the surface */
+		int x0 = rect->top_left.x < 0 ? 0 : rect->top_left.x;
+		int y0 = rect->top_left.y < 0 ? 0 : rect->top_left.y;
+		int x1 = rect->top_left.x + rect->size.width;
+		int y1 = rect->top_left.y + rect->size.height;
+		x1 = x1 > size.width ? size.width : x1;
+		y1 = y1 > size.height ? size.height : y1;
+		view.rect = (ei_rect_t){{x0, y0}, {x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0}};
+	}
+	ei_surface_retain(surface);
+	return view;
+}
+
+
+void ei_surface_view_release(ei_surface_view_t* view) {
+	if(view->surface)
+		ei_surface_release(view->surface);
+	view->surface = NULL;
+}
+
+
+ei_surface_desc_t ei_surface_desc(ei_surface_t surface) {
+	ei_surface_info_t *info = get_info(surface);
+	ei_surface_desc_t desc;
+	desc.pixels = (uint32_t *)hw_surface_get_buffer(surface);
+	desc.size = hw_surface_get_size(surface);
+	desc.pitch = info->pitch ? info->pitch : desc.size.width;
+	desc.format = &info->format;
+	return desc;
+}
+
+
+ei_surface_desc_t ei_surface_view_desc(const ei_surface_view_t* view) {
+	ei_surface_desc_t desc = ei_surface_desc(view->surface);
+	desc.pixels = EI_PIXEL_AT(&desc, view->rect.top_left.x, view->rect.top_left.y);
+	desc.size = view->rect.size;
+	return desc;
+}
+
+
+void ei_surface_set_pitch(ei_surface_t surface, int pitch) {
+	get_info(surface)->pitch = pitch;
+}
+
+
+void* ei_surface_alloc_rows(int width, int height, int pixel_size, int* pitch) {
+	/* rounds the rows up to a multiple of the alignment */
+	int row = (width * pixel_size + EI_ROW_ALIGN - 1) & ~(EI_ROW_ALIGN - 1);
+	void *buffer = NULL;
+	if(posix_memalign(&buffer, EI_ROW_ALIGN, (size_t)row * (height > 0 ? height : 1)) != 0)
+		return NULL;
+	*pitch = row / pixel_size;
+	return buffer;
+}
+
+
+void ei_surface_forget(ei_surface_t surface) {
+	ei_scale_cache_forget(surface);
+	ei_surface_info_t **prev = &buckets[bucket_of(surface)];
+	while(*prev) {
+		if((*prev)->surface == surface) {
+			ei_surface_info_t *info = *prev;
+			*prev = info->next;
+			free(info);
+			return;
+		}
+		prev = &(*prev)->next;
+	}
+}
+
+
+void ei_surface_free(ei_surface_t surface) {
+	ei_surface_forget(surface);
+	hw_surface_free(surface);
+}
@@ -0,0 +1,167 @@
+/**
+ *  @file	ei_text_cache.c
+ *  @brief	Cache of the rendered texts: the coverage of the glyphs of a text, for a font, is
+ *		kept in a mask (from the buffer pool) and tinted with the color at each drawing.
+ *
+ */
+
+#include "ei_text_cache.h"
+#include "ei_surface.h"
+#include "ei_pool.h"
+#include "hw_interface.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of buckets of the text table (power of 2) */
+#define TEXT_BUCKETS 256
+
+
+/* A rendered text */
+typedef struct ei_text_entry_t {
+	char*			text;		///< The text (key).
+	ei_font_t		font;		///< The font (key).
+	unsigned		hash;		///< Hash of the key.
+	ei_text_mask_t		mask;		///< The coverage of the glyphs.
+	struct ei_text_entry_t*	next;		///< Next entry of the same bucket.
+	struct ei_text_entry_t*	newer;		///< Entry used just after this one.
+	struct ei_text_entry_t*	older;		///< Entry used just before this one.
+} ei_text_entry_t;
+
+
+/* hash table of the texts */
+static ei_text_entry_t *buckets[TEXT_BUCKETS];
+/* the entries, from the most recently used to the least recently used */
+static ei_text_entry_t *newest = NULL;
+static ei_text_entry_t *oldest = NULL;
+static int entries_nb = 0;
+/* EI_TRUE once the hardware layer rendered a text without alpha channel */
+static ei_bool_t no_alpha = EI_FALSE;
+
+
+static unsigned hash_of(const char* text, ei_font_t font) {
+	/* FNV-1a */
+	unsigned hash = 2166136261u ^ (unsigned)((uintptr_t)font >> 4);
+	for(; *text; text++)
+		hash = (hash ^ (unsigned char)*text) * 16777619u;
+	return hash;
+}
+
+
+static void unlink_lru(ei_text_entry_t* entry) {
+	if(entry->newer)
+		entry->newer->older = entry->older;
+	else
+		newest = entry->older;
+	if(entry->older)
+		entry->older->newer = entry->newer;
+	else
+		oldest = entry->newer;
+}
+
+
+static void link_newest(ei_text_entry_t* entry) {
+	entry->newer = NULL;
+	entry->older = newest;
+	if(newest)
+		newest->newer = entry;
+	else
+		oldest = entry;
+	newest = entry;
+}
+
+
+static void remove_entry(ei_text_entry_t* entry) {
+	ei_text_entry_t **prev = &buckets[entry->hash & (TEXT_BUCKETS - 1)];
+	while(*prev != entry)
+		prev = &(*prev)->next;
+	*prev = entry->next;
+	unlink_lru(entry);
+	entries_nb--;
+
+	ei_pool_put(entry->mask.coverage);
+	free(entry->text);
+	free(entry);
+}
+
+
+/* renders a text and extracts the coverage of its glyphs (the alpha channel of the surface) */
+static ei_bool_t render(ei_text_mask_t* mask, const char* text, ei_font_t font) {
+	ei_color_t white = {0xff, 0xff, 0xff, 0xff};
+	ei_surface_t surface = hw_text_create_surface(text, font, white);
+	if(!surface)
+		return EI_FALSE;
+
+	hw_surface_lock(surface);
+	ei_surface_desc_t desc = ei_surface_desc(surface);
+	ei_bool_t ok = EI_FALSE;
+	if(desc.format->ia >= 0) {
+		mask->size = desc.size;
+		mask->coverage = ei_pool_get(desc.size.width, desc.size.height, 1, &mask->pitch);
+		if(mask->coverage) {
+			for(int y = 0; y < desc.size.height; y++) {
+				const uint8_t *src = (const uint8_t *)EI_PIXEL_AT(&desc, 0, y) + desc.format->ia;
+				uint8_t *dst = mask->coverage + y * mask->pitch;
+				for(int x = 0; x < desc.size.width; x++)
+					dst[x] = src[4 * x];
+			}
+			ok = EI_TRUE;
+		}
+	} else
+		no_alpha = EI_TRUE;
+	hw_surface_unlock(surface);
+	ei_surface_free(surface);
+	return ok;
+}
+
+
+const ei_text_mask_t* ei_text_cache_get(const char* text, ei_font_t font) {
+	if(no_alpha)
+		return NULL;
+
+	unsigned hash = hash_of(text, font);
+	unsigned b = hash & (TEXT_BUCKETS - 1);
+	for(ei_text_entry_t *entry = buckets[b]; entry; entry = entry->next) {
+		if(entry->hash == hash && entry->font == font && strcmp(entry->text, text) == 0) {
+			/* becomes the most recently used */
+			unlink_lru(entry);
+			link_newest(entry);
+			return &entry->mask;
+		}
+	}
+
+	/* first drawing of this text */
+	ei_text_entry_t *entry = calloc(1, sizeof(ei_text_entry_t));
+	if(!render(&entry->mask, text, font)) {
+		free(entry);
+		return NULL;
+	}
+	entry->text = strdup(text);
+	entry->font = font;
+	entry->hash = hash;
+	entry->next = buckets[b];
+	buckets[b] = entry;
+	link_newest(entry);
+	entries_nb++;
+
+	if(entries_nb > EI_TEXT_CACHE_ENTRIES)
+		remove_entry(oldest);
+	return &entry->mask;
+}
+
+
+void ei_text_cache_forget_font(ei_font_t font) {
+	ei_text_entry_t *entry = newest;
+	while(entry) {
+		ei_text_entry_t *older = entry->older;
+		if(entry->font == font)
+			remove_entry(entry);
+		entry = older;
+	}
+}
+
+
+void ei_text_cache_free(void) {
+	while(oldest)
+		remove_entry(oldest);
+	no_alpha = EI_FALSE;
+}
@@ -0,0 +1,442 @@
+/**
+ *  @file	ei_tiles.c
+ *  @brief	Tile pyramids, to show images too big to be kept in memory: an image is stored in a
+ *		file as square tiles, at its full resolution and at resolutions halved down to a
+ *		single tile. The tiles are read from the file when they are drawn, and the recently
+ *		used ones are kept in a cache.
+ *
+ */
+
+#include "ei_tiles.h"
+#include "ei_image.h"
+#include "ei_image_disk.h"
+#include "ei_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifndef __WIN__
+#include <unistd.h>
+#include <sys/stat.h>
+#else
+#define fseeko	_fseeki64
+#define ftello	_ftelli64
+#endif
+
+/* identifies the pyramid files, and their version */
+#define TILES_MAGIC "EITILE1"
+/* Number of buckets of the tile table (power of 2) */
+#define TILE_BUCKETS 256
+/* size of a tile in a pyramid file (the tiles of the edges are padded) */
+#define TILE_BYTES ((int64_t)EI_TILE_SIZE * EI_TILE_SIZE * 4)
+
+
+/* Header of a pyramid file, followed by the name of the image file (padded to 64 bytes) and the
+   tiles of each level, row by row */
+typedef struct ei_tiles_header_t {
+	char		magic[8];	///< TILES_MAGIC.
+	int64_t		mtime;		///< Modification time of the image file.
+	int64_t		file_size;	///< Size of the image file.
+	int32_t		width;		///< Width of the image.
+	int32_t		height;		///< Height of the image.
+	int32_t		channels[4];	///< Indices of the red, green, blue and alpha channels.
+	int32_t		tile_size;	///< EI_TILE_SIZE.
+	int32_t		name_length;	///< Length of the name of the image file.
+} ei_tiles_header_t;
+
+
+struct ei_tile_pyramid_t {
+	FILE*			file;				///< The pyramid file.
+	ei_pixel_format_t	format;				///< Pixel format of the tiles.
+	int			levels_nb;			///< Number of levels.
+	ei_size_t		sizes[EI_TILES_MAX_LEVELS];	///< Size of each level.
+	int64_t			offsets[EI_TILES_MAX_LEVELS];	///< Offset of the first tile of each level in the file.
+	int			visible;			///< Number of tiles shown at once.
+};
+
+
+/* A tile in the cache */
+typedef struct ei_tile_entry_t {
+	ei_tile_pyramid_t*	pyramid;	///< The pyramid (key).
+	int			level;		///< The level (key).
+	int			column;		///< The column (key).
+	int			row;		///< The row (key).
+	ei_surface_desc_t	desc;		///< The pixels, in a buffer of the pool.
+	struct ei_tile_entry_t*	next;		///< Next entry of the same bucket.
+	struct ei_tile_entry_t*	newer;		///< Entry used just after this one.
+	struct ei_tile_entry_t*	older;		///< Entry used just before this one.
+} ei_tile_entry_t;
+
+
+/* hash table of the tiles */
+static ei_tile_entry_t *buckets[TILE_BUCKETS];
+/* the entries, from the most recently used to the least recently used */
+static ei_tile_entry_t *newest = NULL;
+static ei_tile_entry_t *oldest = NULL;
+static int entries_nb = 0;
+/* the visible tiles of all the pyramids: the cache holds EI_TILE_CACHE_TILES more */
+static int visible_nb = 0;
+static ei_tiles_stats_t stats = {0, 0};
+
+
+static int tiles_across(int length) {
+	return (length + EI_TILE_SIZE - 1) / EI_TILE_SIZE;
+}
+
+
+/* sizes and offsets of the levels of an image, the tiles starting at data_offset */
+static void compute_levels(ei_tile_pyramid_t* pyramid, ei_size_t size, int64_t data_offset) {
+	pyramid->levels_nb = 0;
+	int64_t offset = data_offset;
+	for(;;) {
+		pyramid->sizes[pyramid->levels_nb] = size;
+		pyramid->offsets[pyramid->levels_nb] = offset;
+		pyramid->levels_nb++;
+		offset += (int64_t)tiles_across(size.width) * tiles_across(size.height) * TILE_BYTES;
+		if((size.width <= EI_TILE_SIZE && size.height <= EI_TILE_SIZE) || pyramid->levels_nb == EI_TILES_MAX_LEVELS)
+			break;
+		size = (ei_size_t){(size.width + 1) / 2, (size.height + 1) / 2};
+	}
+}
+
+
+static int64_t data_offset(int name_length) {
+	return ((int64_t)sizeof(ei_tiles_header_t) + name_length + 63) & ~(int64_t)63;
+}
+
+
+/* writes the tiles of a level */
+static ei_bool_t write_level(FILE* file, const uint32_t* pixels, int pitch, ei_size_t size, uint32_t* tile) {
+	for(int ty = 0; ty < size.height; ty += EI_TILE_SIZE) {
+		for(int tx = 0; tx < size.width; tx += EI_TILE_SIZE) {
+			const int w = size.width - tx < EI_TILE_SIZE ? size.width - tx : EI_TILE_SIZE;
+			const int h = size.height - ty < EI_TILE_SIZE ? size.height - ty : EI_TILE_SIZE;
+			if(w < EI_TILE_SIZE || h < EI_TILE_SIZE)
+				memset(tile, 0, TILE_BYTES);
+			for(int y = 0; y < h; y++)
+				memcpy(tile + y * EI_TILE_SIZE, pixels + (int64_t)(ty + y) * pitch + tx, w * sizeof(uint32_t));
+			if(fwrite(tile, TILE_BYTES, 1, file) != 1)
+				return EI_FALSE;
+		}
+	}
+	return EI_TRUE;
+}
+
+
+/* halves a level: each pixel is the mean of 2x2 pixels of the source (the last row or column
+   is repeated on the edges) */
+static void halve(uint32_t* dst, ei_size_t dst_size, const uint32_t* src, int src_pitch, ei_size_t src_size) {
+	for(int y = 0; y < dst_size.height; y++) {
+		const uint32_t *row0 = src + (int64_t)(2 * y) * src_pitch;
+		const uint32_t *row1 = 2 * y + 1 < src_size.height ? row0 + src_pitch : row0;
+		for(int x = 0; x < dst_size.width; x++) {
+			const int x0 = 2 * x;
+			const int x1 = 2 * x + 1 < src_size.width ? x0 + 1 : x0;
+			uint32_t p = 0;
+			for(int i = 0; i < 32; i += 8) {
+				uint32_t sum = ((row0[x0] >> i) & 0xff) + ((row0[x1] >> i) & 0xff) +
+					       ((row1[x0] >> i) & 0xff) + ((row1[x1] >> i) & 0xff);
+				p |= ((sum + 2) >> 2) << i;
+			}
+			dst[x] = p;
+		}
+		dst += dst_size.width;
+	}
+}
+
+
+/* writes the pyramid of an image in a file */
+static ei_bool_t build(FILE* file, ei_tile_pyramid_t* pyramid, const char* filename, ei_surface_t image,
+		       int64_t mtime, int64_t file_size) {
+	ei_tiles_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TILES_MAGIC, sizeof(TILES_MAGIC));
+	header.mtime = mtime;
+	header.file_size = file_size;
+	ei_size_t size = hw_surface_get_size(image);
+	header.width = size.width;
+	header.height = size.height;
+	hw_surface_get_channel_indices(image, &header.channels[0], &header.channels[1], &header.channels[2], &header.channels[3]);
+	header.tile_size = EI_TILE_SIZE;
+	header.name_length = strlen(filename);
+	compute_levels(pyramid, size, data_offset(header.name_length));
+
+	static const char padding[64];
+	size_t padding_length = data_offset(header.name_length) - sizeof(header) - header.name_length;
+	if(fwrite(&header, sizeof(header), 1, file) != 1 ||
+	   fwrite(filename, 1, header.name_length, file) != (size_t)header.name_length ||
+	   fwrite(padding, 1, padding_length, file) != padding_length)
+		return EI_FALSE;
+
+	hw_surface_lock(image);
+	const ei_surface_desc_t desc = ei_surface_desc(image);
+	uint32_t *tile = malloc(TILE_BYTES);
+	ei_bool_t ok = write_level(file, desc.pixels, desc.pitch, size, tile);
+
+	/* each level is computed from the previous one */
+	const uint32_t *level = desc.pixels;
+	int pitch = desc.pitch;
+	uint32_t *previous = NULL;
+	for(int l = 1; ok && l < pyramid->levels_nb; l++) {
+		uint32_t *next = malloc((size_t)pyramid->sizes[l].width * pyramid->sizes[l].height * sizeof(uint32_t));
+		if(!next) {
+			ok = EI_FALSE;
+			break;
+		}
+		halve(next, pyramid->sizes[l], level, pitch, pyramid->sizes[l - 1]);
+		free(previous);
+		previous = next;
+		level = next;
+		pitch = pyramid->sizes[l].width;
+		ok = write_level(file, level, pitch, pyramid->sizes[l], tile);
+	}
+	free(previous);
+	free(tile);
+	hw_surface_unlock(image);
+	return ok && fflush(file) == 0;
+}
+
+
+#ifndef __WIN__
+
+/* name of the pyramid file of an image file, in the cache directory */
+static void pyramid_path(char* path, size_t size, const char* filename) {
+	/* FNV-1a, 64 bits */
+	uint64_t hash = 14695981039346656037ull;
+	for(const char *c = filename; *c; c++)
+		hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+	snprintf(path, size, "%s/%016llx.eit", ei_image_disk_directory(), (unsigned long long)hash);
+}
+
+
+/* checks that a pyramid file is the one of this version of the image, and reads its levels */
+static ei_bool_t read_header(FILE* file, ei_tile_pyramid_t* pyramid, const char* filename, const struct stat* source) {
+	ei_tiles_header_t header;
+	size_t name_length = strlen(filename);
+	char *name = malloc(name_length + 1);
+	ei_bool_t ok = fread(&header, sizeof(header), 1, file) == 1 &&
+		       memcmp(header.magic, TILES_MAGIC, sizeof(TILES_MAGIC)) == 0 &&
+		       header.mtime == (int64_t)source->st_mtime && header.file_size == (int64_t)source->st_size &&
+		       header.name_length == (int32_t)name_length && header.tile_size == EI_TILE_SIZE &&
+		       header.width > 0 && header.height > 0 &&
+		       header.channels[0] == pyramid->format.ir && header.channels[1] == pyramid->format.ig &&
+		       header.channels[2] == pyramid->format.ib && header.channels[3] == pyramid->format.ia &&
+		       fread(name, 1, name_length, file) == name_length && memcmp(name, filename, name_length) == 0;
+	free(name);
+	if(!ok)
+		return EI_FALSE;
+
+	/* the file must hold all the tiles */
+	compute_levels(pyramid, (ei_size_t){header.width, header.height}, data_offset(name_length));
+	const ei_size_t last = pyramid->sizes[pyramid->levels_nb - 1];
+	const int64_t end = pyramid->offsets[pyramid->levels_nb - 1] +
+			    (int64_t)tiles_across(last.width) * tiles_across(last.height) * TILE_BYTES;
+	return fseeko(file, 0, SEEK_END) == 0 && ftello(file) >= end;
+}
+
+#endif
+
+
+ei_tile_pyramid_t* ei_tiles_open(const char* filename, ei_surface_t channels) {
+	ei_tile_pyramid_t *pyramid = calloc(1, sizeof(ei_tile_pyramid_t));
+
+	/* the tiles are in the channel order of the surfaces created for channels */
+	ei_surface_t probe = hw_surface_create(channels, (ei_size_t){1, 1}, EI_TRUE);
+	pyramid->format = *ei_surface_format(probe);
+	pyramid->format.premultiplied = EI_FALSE;
+
+#ifndef __WIN__
+	char path[1024], tmp_path[1040];
+	struct stat source;
+	const ei_bool_t cached = ei_image_disk_directory() && stat(filename, &source) == 0;
+	if(cached) {
+		pyramid_path(path, sizeof(path), filename);
+		FILE *file = fopen(path, "rb");
+		if(file && read_header(file, pyramid, filename, &source)) {
+			ei_surface_free(probe);
+			pyramid->file = file;
+			return pyramid;
+		}
+		if(file)
+			fclose(file);
+	}
+#endif
+
+	/* first opening of this version of the image: the image is decoded once to build the pyramid */
+	ei_surface_t image = hw_image_load(filename, channels);
+	if(image)
+		/* the decoder may use another channel order than the tiles */
+		image = ei_image_convert(image, probe);
+	ei_surface_free(probe);
+	if(!image) {
+		free(pyramid);
+		return NULL;
+	}
+
+#ifndef __WIN__
+	if(cached) {
+		/* written in a temporary file, renamed when it is complete */
+		snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+		pyramid->file = fopen(tmp_path, "w+b");
+		if(pyramid->file && build(pyramid->file, pyramid, filename, image, source.st_mtime, source.st_size) &&
+		   rename(tmp_path, path) == 0) {
+			ei_surface_free(image);
+			return pyramid;
+		}
+		if(pyramid->file)
+			fclose(pyramid->file);
+		remove(tmp_path);
+	}
+#endif
+
+	/* no cache directory: the pyramid is only kept until it is closed */
+	pyramid->file = tmpfile();
+	ei_bool_t ok = pyramid->file && build(pyramid->file, pyramid, filename, image, 0, 0);
+	ei_surface_free(image);
+	if(!ok) {
+		if(pyramid->file)
+			fclose(pyramid->file);
+		free(pyramid);
+		return NULL;
+	}
+	return pyramid;
+}
+
+
+int ei_tiles_levels(const ei_tile_pyramid_t* pyramid) {
+	return pyramid->levels_nb;
+}
+
+
+ei_size_t ei_tiles_level_size(const ei_tile_pyramid_t* pyramid, int level) {
+	return pyramid->sizes[level];
+}
+
+
+static unsigned bucket_of(const ei_tile_pyramid_t* pyramid, int level, int column, int row) {
+	unsigned key = (unsigned)((uintptr_t)pyramid >> 4) ^ (unsigned)level * 131u ^ (unsigned)column * 7919u ^ (unsigned)row * 104729u;
+	return key & (TILE_BUCKETS - 1);
+}
+
+
+static void unlink_lru(ei_tile_entry_t* entry) {
+	if(entry->newer)
+		entry->newer->older = entry->older;
+	else
+		newest = entry->older;
+	if(entry->older)
+		entry->older->newer = entry->newer;
+	else
+		oldest = entry->newer;
+}
+
+
+static void link_newest(ei_tile_entry_t* entry) {
+	entry->newer = NULL;
+	entry->older = newest;
+	if(newest)
+		newest->newer = entry;
+	else
+		oldest = entry;
+	newest = entry;
+}
+
+
+static void remove_entry(ei_tile_entry_t* entry) {
+	ei_tile_entry_t **prev = &buckets[bucket_of(entry->pyramid, entry->level, entry->column, entry->row)];
+	while(*prev != entry)
+		prev = &(*prev)->next;
+	*prev = entry->next;
+	unlink_lru(entry);
+	entries_nb--;
+
+	ei_pool_put(entry->desc.pixels);
+	free(entry);
+}
+
+
+/* reads a tile from the pyramid file */
+static ei_bool_t read_tile(ei_tile_pyramid_t* pyramid, int level, int column, int row, ei_surface_desc_t* desc) {
+	const int columns = tiles_across(pyramid->sizes[level].width);
+	const int64_t offset = pyramid->offsets[level] + ((int64_t)row * columns + column) * TILE_BYTES;
+	if(fseeko(pyramid->file, offset, SEEK_SET) != 0)
+		return EI_FALSE;
+	if(desc->pitch == EI_TILE_SIZE)
+		return fread(desc->pixels, TILE_BYTES, 1, pyramid->file) == 1;
+	for(int y = 0; y < EI_TILE_SIZE; y++)
+		if(fread(desc->pixels + y * desc->pitch, sizeof(uint32_t), EI_TILE_SIZE, pyramid->file) != EI_TILE_SIZE)
+			return EI_FALSE;
+	return EI_TRUE;
+}
+
+
+const ei_surface_desc_t* ei_tiles_get(ei_tile_pyramid_t* pyramid, int level, int column, int row) {
+	if(level < 0 || level >= pyramid->levels_nb)
+		return NULL;
+	const ei_size_t size = pyramid->sizes[level];
+	if(column < 0 || row < 0 || column >= tiles_across(size.width) || row >= tiles_across(size.height))
+		return NULL;
+
+	unsigned b = bucket_of(pyramid, level, column, row);
+	for(ei_tile_entry_t *entry = buckets[b]; entry; entry = entry->next) {
+		if(entry->pyramid == pyramid && entry->level == level && entry->column == column && entry->row == row) {
+			/* becomes the most recently used */
+			unlink_lru(entry);
+			link_newest(entry);
+			stats.hits++;
+			return &entry->desc;
+		}
+	}
+
+	/* first drawing of this tile */
+	ei_tile_entry_t *entry = calloc(1, sizeof(ei_tile_entry_t));
+	entry->desc.pixels = ei_pool_get(EI_TILE_SIZE, EI_TILE_SIZE, 4, &entry->desc.pitch);
+	if(!entry->desc.pixels || !read_tile(pyramid, level, column, row, &entry->desc)) {
+		ei_pool_put(entry->desc.pixels);
+		free(entry);
+		return NULL;
+	}
+	stats.misses++;
+	const int x = column * EI_TILE_SIZE;
+	const int y = row * EI_TILE_SIZE;
+	entry->desc.size = (ei_size_t){size.width - x < EI_TILE_SIZE ? size.width - x : EI_TILE_SIZE,
+				       size.height - y < EI_TILE_SIZE ? size.height - y : EI_TILE_SIZE};
+	entry->desc.format = &pyramid->format;
+	entry->pyramid = pyramid;
+	entry->level = level;
+	entry->column = column;
+	entry->row = row;
+	entry->next = buckets[b];
+	buckets[b] = entry;
+	link_newest(entry);
+	entries_nb++;
+
+	while(entries_nb > visible_nb + EI_TILE_CACHE_TILES)
+		remove_entry(oldest);
+	return &entry->desc;
+}
+
+
+void ei_tiles_set_visible(ei_tile_pyramid_t* pyramid, int tiles) {
+	visible_nb += tiles - pyramid->visible;
+	pyramid->visible = tiles;
+}
+
+
+ei_tiles_stats_t ei_tiles_get_stats(void) {
+	return stats;
+}
+
+
+void ei_tiles_close(ei_tile_pyramid_t* pyramid) {
+	ei_tile_entry_t *entry = newest;
+	while(entry) {
+		ei_tile_entry_t *older = entry->older;
+		if(entry->pyramid == pyramid)
+			remove_entry(entry);
+		entry = older;
+	}
+	visible_nb -= pyramid->visible;
+	fclose(pyramid->file);
+	free(pyramid);
+}
@@ -10,6 +10,8 @@
 #include "ei_application.h"
 #include "ei_draw_more.h"
 #include "ei_calculations.h"
+#include "ei_slab.h"
+#include <string.h>
 
 
 static ei_toplevel_t *resizing_toplevel = NULL;
@@ -21,8 +23,8 @@ ei_bool_t quit_toplevel_event(ei_widget_t* w_quitbutton, ei_event_t* event, void
 	/* the quit button's parent is the toplevel to quit */
 	ei_toplevel_t* toplevel = (ei_toplevel_t *) w_quitbutton->parent;
 	/* invalidates the surface the toplevel occupied */
-	ei_app_invalidate_rect(toplevel->draw_rect);
-	if(*toplevel->closable){
+	ei_app_invalidate_rect(&toplevel->draw_rect);
+	if(toplevel->closable){
 		ei_widget_destroy((ei_widget_t*) toplevel); 
 		return EI_TRUE;
 	}
@@ -45,19 +47,19 @@ ei_bool_t resize(ei_widget_t* w_resizebutton, ei_event_t* event, void* params){
 
 	ei_bool_t redraw = EI_FALSE;
 	/* resizes according to the resizable axes */
-	switch(*resizing_toplevel->resizable){
+	switch(resizing_toplevel->resizable){
 		case ei_axis_both:
 		case ei_axis_x:
-			if(n_width >= resizing_toplevel->min_size->width){
+			if(n_width >= resizing_toplevel->min_size.width){
 				/* sets the new width if superior to the minimal width */
 				resizing_toplevel->widget.requested_size.width = n_width;
 				redraw = EI_TRUE;
 			} else
 				n_width = resizing_toplevel->widget.requested_size.width;
-			if(*resizing_toplevel->resizable == ei_axis_x)
+			if(resizing_toplevel->resizable == ei_axis_x)
 				break;
 		case ei_axis_y:
-			if(n_height >= resizing_toplevel->min_size->height){
+			if(n_height >= resizing_toplevel->min_size.height){
 				/* sets the next height if superior to the minimal height */
 				resizing_toplevel->widget.requested_size.height = n_height;
 				redraw = EI_TRUE;
@@ -90,13 +92,13 @@ ei_bool_t beg_resize(ei_widget_t* w_resizebutton, ei_event_t* event, void* param
 	ei_toplevel_t *toplevel = (ei_toplevel_t *) w_resizebutton->parent;
 
 	/* stops if the toplevel is not resizable */
-	if(*toplevel->resizable == ei_axis_none)
+	if(toplevel->resizable == ei_axis_none)
 		return EI_FALSE;
 
 	resizing_toplevel = toplevel;
 
 	/* the distance between the mouse and the right and bottom sides */
-	offsetptr[0] = w_resizebutton->screen_location.top_left.x + w_resizebutton->screen_location.size.width - event->param.mouse.where.x - (*toplevel->border_width);
+	offsetptr[0] = w_resizebutton->screen_location.top_left.x + w_resizebutton->screen_location.size.width - event->param.mouse.where.x - toplevel->border_width;
 	offsetptr[1] = w_resizebutton->screen_location.top_left.y + w_resizebutton->screen_location.size.height - event->param.mouse.where.y - default_topbar_height;
 	return EI_TRUE;
 }
@@ -130,6 +132,18 @@ ei_bool_t end_move(ei_widget_t* w_toplevel, ei_event_t* event, void* params) {
 }
 
 
+ei_bool_t raise_toplevel(ei_widget_t* widget, ei_event_t* event, void* params) {
+	/* the widget is NULL for a tag: the clicked one is picked */
+	ei_widget_t *picked = ei_widget_pick(&event->param.mouse.where);
+
+	/* the toplevels containing the clicked widget come in front of their siblings */
+	for(ei_widget_t *ancestor = picked; ancestor; ancestor = ancestor->parent)
+		if(!strcmp(ancestor->wclass->name, "toplevel"))
+			ei_widget_raise(ancestor);
+	return EI_FALSE;
+}
+
+
 ei_bool_t beg_move(ei_widget_t* w_toplevel, ei_event_t* event, void* params) {
 	ei_toplevel_t *toplevel = (ei_toplevel_t *) w_toplevel;
 
@@ -154,30 +168,12 @@ void* alloctoplevel(void) {
 
 
 void releasetoplevel(struct ei_widget_t* widget) {
+	/* The attributes are stored in the toplevel. Its descendants are destroyed: the chunks they
+	   were allocated in are released at once */
 	/* The widget itself is *not* destroyed by this function */
 	ei_toplevel_t* widget_toplevel = (ei_toplevel_t*)widget;
-
-    /* frees the title attributes */
-	if(widget_toplevel->title)
-        free(widget_toplevel->title);
-    if(widget_toplevel->title_font)
-        free(widget_toplevel->title_font);
-    if(widget_toplevel->border_width)
-        free(widget_toplevel->border_width);
-	if(widget_toplevel->background_color)
-        free(widget_toplevel->background_color);
-    if(widget->content_rect && widget->content_rect != &widget->screen_location)
-		free(widget->content_rect);
-
-    /* frees the toplevel special attributes */
-    if(widget_toplevel->closable)
-        free(widget_toplevel->closable);
-    if(widget_toplevel->resizable)
-        free(widget_toplevel->resizable);
-    if(widget_toplevel->min_size)
-        free(widget_toplevel->min_size);
-    if(widget_toplevel->draw_rect)
-    	free(widget_toplevel->draw_rect);
+	ei_slab_arena_free(widget_toplevel->arena);
+	widget_toplevel->arena = NULL;
 }
 
 
@@ -187,33 +183,36 @@ void drawtoplevel(struct ei_widget_t*		widget,
 					  ei_rect_t*		clipper) {
 	ei_toplevel_t * widget_toplevel = (ei_toplevel_t *) widget;
 
-	int corner_radius = 0;
-    int *border_width = widget_toplevel->border_width;
-    ei_color_t *color = widget_toplevel->background_color;
-    const char *text = *widget_toplevel->title;
-    ei_font_t *text_font = widget_toplevel->title_font;
-
+    const char *text = widget_toplevel->title;
 
-    ei_rect_t all_clipper = get_ei_rect_intersection(*clipper, *widget_toplevel->draw_rect);
+    ei_rect_t all_clipper = get_ei_rect_intersection(*clipper, widget_toplevel->draw_rect);
     ei_rect_t content_clipper = get_ei_rect_intersection(*clipper, *widget->content_rect);
 
     /* Drawing... */
     ei_color_t border_color = {50, 50, 50, 255};
     ei_fill(surface, &border_color, &all_clipper);
-	ei_fill(surface, widget_toplevel->background_color, &content_clipper);
+	ei_fill(surface, &widget_toplevel->background_color, &content_clipper);
 
-    /* filling the pick_surface with the widget's pick_color */
-    ei_fill(pick_surface, widget->pick_color, &all_clipper);
+    /* filling the pick_surface with the widget's pick_color (only in the offscreen picking mode) */
+    if(pick_surface)
+        ei_fill(pick_surface, &widget->pick_color, &all_clipper);
 
     if(text) {
-        /* computing text width and text height */
-        ei_point_t where = {widget_toplevel->draw_rect->top_left.x+25+*widget_toplevel->border_width, widget_toplevel->draw_rect->top_left.y};
+        ei_point_t where = ei_toplevel_title_rect(widget_toplevel, text).top_left;
         const ei_color_t white = {255, 255, 255, 255};
         ei_draw_text(surface, &where, text, NULL, white, &all_clipper);
     }
 }
 
 
+ei_rect_t ei_toplevel_title_rect(ei_toplevel_t* toplevel, const char* title) {
+	/* computing text width and text height */
+	int tw; int th;
+	hw_text_compute_size(title, ei_default_font, &tw, &th);
+	return (ei_rect_t){{toplevel->draw_rect.top_left.x+25+toplevel->border_width, toplevel->draw_rect.top_left.y}, {tw, th}};
+}
+
+
 void setdefaultstoplevel(struct ei_widget_t* widget) {
 	/* casting the widget (pointer) into a toplevel (pointer) */
 	ei_toplevel_t * widget_toplevel = (ei_toplevel_t *)widget;
@@ -221,44 +220,19 @@ void setdefaultstoplevel(struct ei_widget_t* widget) {
 	widget->content_rect = &widget->screen_location;
 
 	/* configures the default title attributes */
-	if(widget_toplevel->title)
-		free(widget_toplevel->title);
-	widget_toplevel->title = malloc(sizeof(char[9]));
-	*widget_toplevel->title = "Toplevel";
-	
-
-	if(widget_toplevel->title_font == NULL)
-		widget_toplevel->title_font = malloc(sizeof(ei_font_t));
-	*(widget_toplevel->title_font) = ei_default_font;
-
-	if(widget_toplevel->draw_rect == NULL)
-		widget_toplevel->draw_rect = malloc(sizeof(ei_rect_t));
-
-	if(widget_toplevel->border_width == NULL)
-		widget_toplevel->border_width = malloc(sizeof(int));
-	*(widget_toplevel->border_width) = 4;
-
-	if(widget_toplevel->background_color == NULL)
-		widget_toplevel->background_color = malloc(sizeof(ei_color_t));
-	*(widget_toplevel->background_color) = ei_default_background_color;
-
+	widget_toplevel->title = "Toplevel";
+	widget_toplevel->title_font = ei_default_font;
+	widget_toplevel->border_width = 4;
+	widget_toplevel->background_color = ei_default_background_color;
 
 	/* configures the default toplevel special attributes */
-	if(widget_toplevel->closable == NULL)
-		widget_toplevel->closable = malloc(sizeof(ei_bool_t));
-	*(widget_toplevel->closable) = EI_TRUE;
-
-	if(widget_toplevel->resizable == NULL)
-		widget_toplevel->resizable = malloc(sizeof(ei_axis_set_t));
-	*(widget_toplevel->resizable) = ei_axis_both;
-
-    if(widget_toplevel->min_size == NULL)
-		widget_toplevel->min_size = malloc(sizeof(ei_size_t));
-	*(widget_toplevel->min_size) = (ei_size_t){160,120};
+	widget_toplevel->closable = EI_TRUE;
+	widget_toplevel->resizable = ei_axis_both;
+	widget_toplevel->min_size = (ei_size_t){160,120};
 
 
 	/* places the quit button, the foreground and the resize button */
-	if(*widget_toplevel->resizable) {
+	if(widget_toplevel->resizable) {
 		ei_button_t* resize_button = (ei_button_t *) ei_widget_create("button", widget, NULL, NULL);
 		ei_size_t resize_button_size = {20,20};
 		ei_color_t resize_button_color = ei_default_background_color;
@@ -268,6 +242,7 @@ void setdefaultstoplevel(struct ei_widget_t* widget) {
 				    NULL, &resize_button_corner_radius, &resize_button_relief, NULL, NULL, NULL, NULL,
 				    NULL, NULL, NULL, NULL, NULL);
 		resize_button->is_resize_button = EI_TRUE;
+		widget_toplevel->resize_button = (ei_widget_t *) resize_button;
 
 		ei_anchor_t resize_button_anchor = ei_anc_southeast;
 		float rel_x = 1.0;
@@ -283,7 +258,7 @@ void setdefaultstoplevel(struct ei_widget_t* widget) {
 	ei_bind(ei_ev_mouse_buttondown, widget, NULL, beg_move, NULL);
 
 	/* configures the quit button */
-	if(*widget_toplevel->closable) {
+	if(widget_toplevel->closable) {
 		ei_button_t* quit_button = (ei_button_t *) ei_widget_create("button", widget, NULL, NULL);
 		ei_size_t quit_button_size = {10,10};
 		ei_color_t quit_button_color = {0xFF,0,0,0xFF};
@@ -294,6 +269,7 @@ void setdefaultstoplevel(struct ei_widget_t* widget) {
 				    NULL, NULL, NULL, NULL, NULL);
 		quit_button->no_clipping = EI_TRUE;
 		quit_button->is_quit_button = EI_TRUE;
+		widget_toplevel->quit_button = (ei_widget_t *) quit_button;
 
 		int quit_button_x = 6;
 		int quit_button_y = -default_topbar_height+9;
@@ -310,34 +286,25 @@ void setdefaultstoplevel(struct ei_widget_t* widget) {
 void geomnotifytoplevel(struct ei_widget_t* widget) {
 
 	ei_toplevel_t * widget_toplevel = (ei_toplevel_t *) widget;
-	int *border_width = ((ei_toplevel_t*)widget)->border_width;
-	ei_rect_t old_rect = *widget->content_rect;
-	if(!widget->content_rect || widget->content_rect == &widget->screen_location)
-		widget->content_rect = malloc(sizeof(ei_rect_t));
+	const int border_width = widget_toplevel->border_width;
+	widget->content_rect = &widget->inner_rect;
     *widget->content_rect = (ei_rect_t){
     	{
-    		widget->screen_location.top_left.x+(*border_width),
+    		widget->screen_location.top_left.x+border_width,
     		widget->screen_location.top_left.y+default_topbar_height
     	},
     	widget->screen_location.size
     };
 
 		/* drawing the widget with relief */
-    if(!widget_toplevel->draw_rect)
-    	widget_toplevel->draw_rect = malloc(sizeof(ei_rect_t));
-    *widget_toplevel->draw_rect = (ei_rect_t){widget->screen_location.top_left,
+    widget_toplevel->draw_rect = (ei_rect_t){widget->screen_location.top_left,
         {
-            widget->screen_location.size.width+2*(*border_width),
-            widget->screen_location.size.height+(*border_width)+default_topbar_height
+            widget->screen_location.size.width+2*border_width,
+            widget->screen_location.size.height+border_width+default_topbar_height
         }
     };
 
-	ei_widget_t *sibling = widget->children_head;
-	while(sibling) {
-		if(sibling->geom_params)
-			sibling->geom_params->manager->runfunc(sibling);
-		sibling = sibling->next_sibling;
-	}
-	ei_rect_t inv_rect = extend_rect(*((ei_toplevel_t*)widget)->draw_rect);
+	ei_geometrymanager_run_children(widget);
+	ei_rect_t inv_rect = extend_rect(widget_toplevel->draw_rect);
 	ei_app_invalidate_rect(&inv_rect);
 }
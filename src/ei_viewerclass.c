@@ -0,0 +1,200 @@
+/**
+ *  @file	ei_viewerclass.c
+ *  @brief	allocfunc, releasefunc, drawfunc, setdefaultsfunc, geomnotifyfunc of viewer class.
+ *
+ */
+
+#include "ei_viewerclass.h"
+#include "ei_geometrymanager.h"
+#include "ei_draw_more.h"
+#include "ei_application.h"
+#include "ei_calculations.h"
+
+/* the viewer being panned with the mouse, and the last position of the mouse */
+static ei_viewer_t *panning_viewer = NULL;
+static ei_point_t pan_last;
+
+
+ei_bool_t beg_pan(ei_widget_t* w_viewer, ei_event_t* event, void* params) {
+	/* Precondition : there is a viewer behind the cursor */
+	if(event->param.mouse.button != ei_mouse_button_left)
+		return EI_FALSE;
+	panning_viewer = (ei_viewer_t *)ei_widget_pick(&event->param.mouse.where);
+	if(!panning_viewer)
+		return EI_FALSE;
+	pan_last = event->param.mouse.where;
+	return EI_FALSE;
+}
+
+
+ei_bool_t pan(ei_widget_t* w_viewer, ei_event_t* event, void* params) {
+	if(!panning_viewer)
+		return EI_FALSE;
+
+	/* the image follows the mouse */
+	ei_point_t where = event->param.mouse.where;
+	ei_viewer_pan((ei_widget_t *)panning_viewer, pan_last.x - where.x, pan_last.y - where.y);
+	pan_last = where;
+	return EI_FALSE;
+}
+
+
+ei_bool_t end_pan(ei_widget_t* w_viewer, ei_event_t* event, void* params) {
+	panning_viewer = NULL;
+	return EI_FALSE;
+}
+
+
+void* allocviewer(void) {
+	/* Dynamically allocates memory for a viewer */
+	ei_viewer_t* widget_viewer = calloc(1, sizeof(ei_viewer_t));
+	return widget_viewer;
+}
+
+
+void releaseviewer(struct ei_widget_t* widget) {
+	/* The widget itself is *not* destroyed by this function */
+	ei_viewer_t* widget_viewer = (ei_viewer_t*)widget;
+	if(panning_viewer == widget_viewer)
+		panning_viewer = NULL;
+
+	if(widget_viewer->pyramid)
+		ei_tiles_close(widget_viewer->pyramid);
+}
+
+
+void drawviewer(struct ei_widget_t*	widget,
+				ei_surface_t	surface,
+				ei_surface_t	pick_surface,
+				ei_rect_t*		clipper) {
+	ei_viewer_t* widget_viewer = (ei_viewer_t*)widget;
+	const ei_surface_desc_t dst = ei_surface_desc(surface);
+
+	/* the drawn part of the widget */
+	ei_rect_t clip = clipper ? get_ei_rect_intersection(*clipper, widget->screen_location) : widget->screen_location;
+	clip = get_ei_rect_intersection(clip, (ei_rect_t){{0, 0}, dst.size});
+	if(clip.size.width <= 0 || clip.size.height <= 0)
+		return;
+
+	ei_fill(surface, &widget_viewer->color, &clip);
+	if(pick_surface) {
+		ei_linked_point_t *pick_pts = ei_rounded_frame_all(widget->screen_location, 0);
+		ei_draw_polygon(pick_surface, pick_pts, widget->pick_color, &clip);
+		ei_free_linked_points_list(pick_pts);
+	}
+	if(!widget_viewer->pyramid)
+		return;
+
+	/* the part of the level in the clipper */
+	const ei_point_t origin = {widget->content_rect->top_left.x - widget_viewer->offset.x,
+				   widget->content_rect->top_left.y - widget_viewer->offset.y};
+	const ei_size_t level_size = ei_tiles_level_size(widget_viewer->pyramid, widget_viewer->level);
+
+	/* the cache must hold all the tiles shown by the viewer, not only the ones of the clipper */
+	ei_rect_t visible = get_ei_rect_intersection(*widget->content_rect, (ei_rect_t){{0, 0}, dst.size});
+	visible = get_ei_rect_intersection(visible, (ei_rect_t){origin, level_size});
+	int tiles = 0;
+	if(visible.size.width > 0 && visible.size.height > 0) {
+		const int vx = visible.top_left.x - origin.x;
+		const int vy = visible.top_left.y - origin.y;
+		tiles = ((vx + visible.size.width - 1) / EI_TILE_SIZE - vx / EI_TILE_SIZE + 1) *
+			((vy + visible.size.height - 1) / EI_TILE_SIZE - vy / EI_TILE_SIZE + 1);
+	}
+	ei_tiles_set_visible(widget_viewer->pyramid, tiles);
+
+	ei_rect_t shown = get_ei_rect_intersection((ei_rect_t){origin, level_size}, clip);
+	if(shown.size.width <= 0 || shown.size.height <= 0)
+		return;
+
+	/* only the tiles of this part are drawn: the tiles which are still in the cache are not read again */
+	const int x0 = shown.top_left.x - origin.x;
+	const int y0 = shown.top_left.y - origin.y;
+	for(int row = y0 / EI_TILE_SIZE; row <= (y0 + shown.size.height - 1) / EI_TILE_SIZE; row++) {
+		for(int column = x0 / EI_TILE_SIZE; column <= (x0 + shown.size.width - 1) / EI_TILE_SIZE; column++) {
+			const ei_surface_desc_t *tile = ei_tiles_get(widget_viewer->pyramid, widget_viewer->level, column, row);
+			if(!tile)
+				continue;
+			ei_point_t where = {origin.x + column * EI_TILE_SIZE, origin.y + row * EI_TILE_SIZE};
+			ei_rect_t dst_rect = get_ei_rect_intersection((ei_rect_t){where, tile->size}, shown);
+			ei_rect_t src_rect = {{dst_rect.top_left.x - where.x, dst_rect.top_left.y - where.y}, dst_rect.size};
+			ei_copy_desc(&dst, &dst_rect, tile, &src_rect, EI_TRUE);
+		}
+	}
+}
+
+
+void setdefaultsviewer(struct ei_widget_t* widget) {
+	ei_viewer_t* widget_viewer = (ei_viewer_t*)widget;
+
+	widget_viewer->color = ei_default_background_color;
+
+	if(widget_viewer->pyramid)
+		ei_tiles_close(widget_viewer->pyramid);
+	widget_viewer->pyramid = NULL;
+	widget_viewer->level = 0;
+	widget_viewer->offset = (ei_point_t){0, 0};
+	widget->content_rect = &widget->screen_location;
+}
+
+
+void ei_viewer_clamp_offset(ei_viewer_t* viewer) {
+	if(!viewer->pyramid)
+		return;
+	const ei_size_t size = ei_tiles_level_size(viewer->pyramid, viewer->level);
+	const ei_size_t view = viewer->widget.content_rect->size;
+	if(size.width <= view.width)
+		viewer->offset.x = (size.width - view.width) / 2;
+	else
+		viewer->offset.x = max(0, min(viewer->offset.x, size.width - view.width));
+	if(size.height <= view.height)
+		viewer->offset.y = (size.height - view.height) / 2;
+	else
+		viewer->offset.y = max(0, min(viewer->offset.y, size.height - view.height));
+}
+
+
+void geomnotifyviewer(struct ei_widget_t* widget) {
+	ei_viewer_clamp_offset((ei_viewer_t*)widget);
+	ei_geometrymanager_run_children(widget);
+	ei_app_invalidate_rect(&widget->screen_location);
+}
+
+
+void ei_viewer_pan(ei_widget_t* widget, int dx, int dy) {
+	ei_viewer_t* widget_viewer = (ei_viewer_t*)widget;
+	const ei_point_t old_offset = widget_viewer->offset;
+	widget_viewer->offset.x += dx;
+	widget_viewer->offset.y += dy;
+	ei_viewer_clamp_offset(widget_viewer);
+	if(widget_viewer->offset.x != old_offset.x || widget_viewer->offset.y != old_offset.y)
+		ei_app_invalidate_rect(widget->content_rect);
+}
+
+
+void ei_viewer_zoom(ei_widget_t* widget, int levels, const ei_point_t* around) {
+	ei_viewer_t* widget_viewer = (ei_viewer_t*)widget;
+	if(!widget_viewer->pyramid)
+		return;
+	int level = widget_viewer->level - levels;
+	level = max(0, min(level, ei_tiles_levels(widget_viewer->pyramid) - 1));
+	if(level == widget_viewer->level)
+		return;
+
+	/* the pixel of the image under around stays under it */
+	const ei_rect_t *content = widget->content_rect;
+	const int px = around ? around->x - content->top_left.x : content->size.width / 2;
+	const int py = around ? around->y - content->top_left.y : content->size.height / 2;
+	int64_t x = widget_viewer->offset.x + px;
+	int64_t y = widget_viewer->offset.y + py;
+	if(level < widget_viewer->level) {
+		x *= (int64_t)1 << (widget_viewer->level - level);
+		y *= (int64_t)1 << (widget_viewer->level - level);
+	} else {
+		x /= (int64_t)1 << (level - widget_viewer->level);
+		y /= (int64_t)1 << (level - widget_viewer->level);
+	}
+	widget_viewer->level = level;
+	widget_viewer->offset = (ei_point_t){(int)x - px, (int)y - py};
+	ei_viewer_clamp_offset(widget_viewer);
+	ei_app_invalidate_rect(widget->content_rect);
+}
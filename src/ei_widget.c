@@ -9,13 +9,107 @@
 #include "ei_buttonclass.h"
 #include "ei_application.h"
 #include "ei_toplevelclass.h"
+#include "ei_viewerclass.h"
 #include "ei_event_more.h"
 #include "ei_placermanager.h"
 #include "ei_calculations.h"
+#include "ei_picking.h"
+#include "ei_image.h"
+#include "ei_slab.h"
+#include "ei_geometry_store.h"
+#include "ei_draw_more.h"
+#include "ei_utils.h"
 #include <string.h>
 
-static uint32_t wid_id = 0;
-extern ei_surface_t pick_surface;
+
+/* Replaces the image of a frame or a button by a view on img_rect of img (or by nothing if img
+   is NULL): the surface is shared, not copied. */
+static void set_image(unsigned *set, ei_surface_view_t *view, ei_surface_t img, ei_rect_t **img_rect) {
+	if(*set & ei_attr_img)
+		ei_surface_view_release(view);
+	*set &= ~ei_attr_img;
+	if(img) {
+		*view = ei_surface_view(img, img_rect ? *img_rect : NULL);
+		*set |= ei_attr_img;
+	}
+}
+
+
+/* Replaces the text of a frame or a button (by nothing if text is NULL) */
+static void set_text(unsigned *set, ei_widget_text_t field, const char *text) {
+	if(text) {
+		snprintf(field, sizeof(ei_widget_text_t), "%s", text);
+		*set |= ei_attr_text;
+	} else
+		*set &= ~ei_attr_text;
+}
+
+
+/* Replaces the image scaling of a frame or a button (NULL for the natural size) */
+static void set_image_scaling(unsigned *set, ei_image_scaling_t *field, const ei_image_scaling_t *scaling) {
+	if(scaling && scaling->mode != ei_image_natural) {
+		*field = *scaling;
+		*set |= ei_attr_img_scaling;
+	} else
+		*set &= ~ei_attr_img_scaling;
+}
+
+
+static ei_bool_t same_color(ei_color_t a, ei_color_t b) {
+	return a.red == b.red && a.green == b.green && a.blue == b.blue && a.alpha == b.alpha;
+}
+
+
+/* Whether the image of a frame or a button changed: the pixels of a surface may have changed
+   since it was set, so setting a surface again counts as a change */
+static ei_bool_t image_changed(unsigned old_set, unsigned set, const ei_surface_t *img) {
+	return (old_set & ei_attr_img) != (set & ei_attr_img) || (img && *img);
+}
+
+
+/* Whether the text of a frame or a button is drawn differently */
+static ei_bool_t text_changed(unsigned old_set, const char *old_text, ei_font_t old_font, ei_color_t old_color, ei_anchor_t old_anchor,
+			      unsigned set, const char *text, ei_font_t font, ei_color_t color, ei_anchor_t anchor) {
+	if((old_set & ei_attr_text) != (set & ei_attr_text))
+		return EI_TRUE;
+	return (set & ei_attr_text) && (strcmp(old_text, text) || old_font != font ||
+					!same_color(old_color, color) || old_anchor != anchor);
+}
+
+
+/* The rect where a frame or a button draws its text, empty if it has none */
+static ei_rect_t text_rect(ei_widget_t *widget, unsigned set, const char *text, ei_font_t font, ei_anchor_t anchor) {
+	if(!(set & ei_attr_text))
+		return ei_rect_zero();
+	return ei_text_rect(text, font, anchor, *widget->content_rect);
+}
+
+
+/* Runs the geometry manager of a configured widget if its requested size changed. Returns
+   whether its screen_location changed (the geometry manager invalidated where it was). */
+static ei_bool_t relayout(ei_widget_t *widget, ei_size_t old_requested_size) {
+	if(widget->requested_size.width == old_requested_size.width &&
+	   widget->requested_size.height == old_requested_size.height)
+		return EI_FALSE;
+	const ei_rect_t old_screen_location = widget->screen_location;
+	widget->geom_params->manager->runfunc(widget);
+	return	widget->screen_location.top_left.x != old_screen_location.top_left.x ||
+		widget->screen_location.top_left.y != old_screen_location.top_left.y ||
+		widget->screen_location.size.width != old_screen_location.size.width ||
+		widget->screen_location.size.height != old_screen_location.size.height;
+}
+
+
+/* Invalidates the old and new places of a text, clipped by the widget. A pressed button draws its
+   text shifted by at most its border width. */
+static void invalidate_text(ei_widget_t *widget, ei_rect_t old_text, ei_rect_t text, int shift) {
+	ei_rect_t rect = get_ei_rect_union(old_text, text);
+	rect.size.width += shift;
+	rect.size.height += shift;
+	rect = get_ei_rect_intersection(rect, widget->screen_location);
+	if(rect.size.width > 0 && rect.size.height > 0)
+		ei_app_invalidate_rect(&rect);
+}
 
 
 void ei_frame_configure(ei_widget_t *widget,
@@ -30,6 +124,11 @@ void ei_frame_configure(ei_widget_t *widget,
 						ei_surface_t *img,
 						ei_rect_t **img_rect,
 						ei_anchor_t *img_anchor) {
+	/* the attributes before the call: only what changed is drawn again */
+	if(widget->geom_params)
+		ei_geometrymanager_resolve(widget);
+	const ei_frame_t old = *(ei_frame_t *)widget;
+
 	if (requested_size != NULL)
 		widget->requested_size = *requested_size;
 	else if(text && *text) {
@@ -37,7 +136,7 @@ void ei_frame_configure(ei_widget_t *widget,
 		hw_text_compute_size(*text, text_font ? *text_font : ei_default_font, &w, &h);
 		widget->requested_size = (ei_size_t){w+2*(border_width?*border_width:0), h+2*(border_width?*border_width:0)};
 	} else if(img && *img) {
-		widget->requested_size = hw_surface_get_size(*img);
+		widget->requested_size = (img_rect && *img_rect) ? (*img_rect)->size : hw_surface_get_size(*img);
 		widget->requested_size.width += 2*(border_width?*border_width:0);
 		widget->requested_size.height += 2*(border_width?*border_width:0);
 	} else
@@ -47,36 +146,13 @@ void ei_frame_configure(ei_widget_t *widget,
 	ei_frame_t *widget_frame;
 	widget_frame = (ei_frame_t *)widget;
 
-	/* configures the color */
-	if(!color) {
-		if(!widget_frame->color) {
-			widget_frame->color = malloc(sizeof(ei_color_t));
-			*(widget_frame->color) = ei_default_background_color;
-		}
-	} else
-		*(widget_frame->color) = *color;
-
-	/* configures the relief */
-	if(!relief) {
-		if(!widget_frame->relief) {
-			widget_frame->relief = malloc(sizeof(ei_relief_t));
-			*(widget_frame->relief) = ei_relief_none;
-		}
-	} else
-		*(widget_frame->relief) = *relief;
-
-	/* configures the border width */
-	if(!border_width) {
-		if(!widget_frame->border_width) {
-			widget_frame->border_width = malloc(sizeof(int));
-			*(widget_frame->border_width) = 0;
-			widget->content_rect = &widget->screen_location;
-		}
-	} else {
-		*(widget_frame->border_width) = *border_width;
-		if(widget->content_rect != &widget->screen_location)
-			widget->content_rect = calloc(1, sizeof(ei_rect_t));
-	}
+	/* configures the color, relief and border width (the defaults are set at the creation) */
+	if(color)
+		widget_frame->color = *color;
+	if(relief)
+		widget_frame->relief = *relief;
+	if(border_width)
+		widget_frame->border_width = *border_width;
 
 	/* 
 		configures the text or image :
@@ -100,72 +176,37 @@ void ei_frame_configure(ei_widget_t *widget,
 		exit(EXIT_FAILURE);
 	} else if(text != NULL && strlen((char *)text) < 40) {
 		/* configures the text */
-		if(*text) {
-			if(widget_frame->text)
-				free(widget_frame->text);
-			widget_frame->text = calloc(1, sizeof(ei_widget_text_t));
-			strcpy(*(widget_frame->text), *text);
-		} else
-			widget_frame->text = NULL;
-		widget_frame->img = NULL;
+		set_text(&widget_frame->set, widget_frame->text, *text);
+		set_image(&widget_frame->set, &widget_frame->img, NULL, NULL);
 	} else if(img) {
-		/* configures the image */
-		if(*img) {
-			if (widget_frame->img == NULL)
-				widget_frame->img = malloc(sizeof(ei_surface_t));
-			*(widget_frame->img) = *img;
-
-			/* configures the rect */
-			if(img_rect) {
-				if (widget_frame->img_rect == NULL)
-					widget_frame->img_rect = malloc(sizeof(ei_rect_t));
-				*(widget_frame->img_rect) = **img_rect;
-			}
-		} else
-			widget_frame->img = NULL;
-		widget_frame->text = NULL;
+		/* configures the image and its rect */
+		set_image(&widget_frame->set, &widget_frame->img, *img, img_rect);
+		set_text(&widget_frame->set, widget_frame->text, NULL);
 	}
 
-	/* configures the text font */
-	if(!text_font) {
-		if(!widget_frame->text_font) {
-			widget_frame->text_font = malloc(sizeof(ei_font_t));
-			*(widget_frame->text_font) = ei_default_font;
-		}
-	} else
-		*(widget_frame->text_font) = *text_font;
-
-	/* configures the text color */
-	if(!text_color) {
-		if(!widget_frame->text_color) {
-			widget_frame->text_color = malloc(sizeof(ei_color_t));
-			*(widget_frame->text_color) = ei_font_default_color;
-		}
-	} else
-		*(widget_frame->text_color) = *text_color;
-
-	/* configures the text anchor */
-	if(!text_anchor) {
-		if(!widget_frame->text_anchor) {
-			widget_frame->text_anchor = malloc(sizeof(ei_anchor_t));
-			*(widget_frame->text_anchor) = ei_anc_center;
-		}
-	} else
-		*(widget_frame->text_anchor) = *text_anchor;
-
-	/* configures the image anchor */
-	if(!img_anchor) {
-		if (!widget_frame->img_anchor) {
-			widget_frame->img_anchor = malloc(sizeof(ei_anchor_t));
-			*(widget_frame->img_anchor) = ei_anc_center;
-		}
-	} else
-		*(widget_frame->img_anchor) = *img_anchor;
-
-	if(widget->geom_params) {
-		widget->geom_params->manager->runfunc(widget);
+	/* configures the text font, color and anchor, and the image anchor */
+	if(text_font)
+		widget_frame->text_font = *text_font;
+	if(text_color)
+		widget_frame->text_color = *text_color;
+	if(text_anchor)
+		widget_frame->text_anchor = *text_anchor;
+	if(img_anchor)
+		widget_frame->img_anchor = *img_anchor;
+
+	if(!widget->geom_params)
+		return;
+	if(relayout(widget, old.widget.requested_size) ||
+	   widget_frame->border_width != old.border_width || widget_frame->relief != old.relief ||
+	   !same_color(widget_frame->color, old.color) || image_changed(old.set, widget_frame->set, img) ||
+	   ((widget_frame->set & ei_attr_img) && widget_frame->img_anchor != old.img_anchor)) {
 		ei_rect_t inv_rect = extend_rect(widget->screen_location);
-        ei_app_invalidate_rect(&inv_rect);
+		ei_app_invalidate_rect(&inv_rect);
+	} else if(text_changed(old.set, old.text, old.text_font, old.text_color, old.text_anchor,
+			       widget_frame->set, widget_frame->text, widget_frame->text_font, widget_frame->text_color, widget_frame->text_anchor)) {
+		/* the text only: where it was and where it is */
+		invalidate_text(widget, text_rect(widget, old.set, old.text, old.text_font, old.text_anchor),
+				text_rect(widget, widget_frame->set, widget_frame->text, widget_frame->text_font, widget_frame->text_anchor), 0);
 	}
 }
 
@@ -184,6 +225,11 @@ void ei_button_configure	(ei_widget_t*		widget,
 							 ei_anchor_t*		img_anchor,
 							 ei_callback_t*		callback,
 							 void**			user_param) {
+	/* the attributes before the call: only what changed is drawn again */
+	if(widget->geom_params)
+		ei_geometrymanager_resolve(widget);
+	const ei_button_t old = *(ei_button_t *)widget;
+
 	if(requested_size != NULL)
 		widget->requested_size = *requested_size;
 	else if(text && *text) {
@@ -191,7 +237,7 @@ void ei_button_configure	(ei_widget_t*		widget,
 		hw_text_compute_size(*text, text_font ? *text_font : ei_default_font, &w, &h);
 		widget->requested_size = (ei_size_t){w+2*(border_width?*border_width:0), h+2*(border_width?*border_width:0)};
 	} else if(img && *img) {
-		widget->requested_size = hw_surface_get_size(*img);
+		widget->requested_size = (img_rect && *img_rect) ? (*img_rect)->size : hw_surface_get_size(*img);
 		widget->requested_size.width += 2*(border_width?*border_width:0);
 		widget->requested_size.height += 2*(border_width?*border_width:0);
 	} else
@@ -201,45 +247,15 @@ void ei_button_configure	(ei_widget_t*		widget,
 	ei_button_t *widget_button;
 	widget_button = (ei_button_t*)widget;
 
-	/* configures the border width */
-	if(!border_width) {
-		if(!widget_button->border_width) {
-			widget_button->border_width = malloc(sizeof(int));
-			*(widget_button->border_width) = k_default_button_border_width;
-			widget->content_rect = &widget->screen_location;
-		}
-	} else {
-		*(widget_button->border_width) = *border_width;
-		if(widget->content_rect != &widget->screen_location)
-			widget->content_rect = calloc(1, sizeof(ei_rect_t));
-	}
-
-	/* configures the corner radius */
-	if(!corner_radius) {
-		if(!widget_button->corner_radius) {
-			widget_button->corner_radius = malloc(sizeof(int));
-			*(widget_button->corner_radius) = k_default_button_corner_radius;
-		}
-	} else
-		*(widget_button->corner_radius) = *corner_radius;
-
-	/* configures the color */
-	if(!color) {
-		if(!widget_button->color) {
-			widget_button->color = malloc(sizeof(ei_color_t));
-			*(widget_button->color) = ei_default_background_color;
-		}
-	} else
-		*(widget_button->color) = *color;
-
-	/* configures the relief */
-	if(!relief) {
-		if(!widget_button->relief) {
-			widget_button->relief = malloc(sizeof(ei_relief_t));
-			*(widget_button->relief) = ei_relief_raised;
-		}
-	} else
-		*(widget_button->relief) = *relief;
+	/* configures the border width, corner radius, color and relief (the defaults are set at the creation) */
+	if(border_width)
+		widget_button->border_width = *border_width;
+	if(corner_radius)
+		widget_button->corner_radius = *corner_radius;
+	if(color)
+		widget_button->color = *color;
+	if(relief)
+		widget_button->relief = *relief;
 
 	/* 
 		configures the text or image :
@@ -263,94 +279,47 @@ void ei_button_configure	(ei_widget_t*		widget,
 		exit(EXIT_FAILURE);
 	} else if(text && strlen((char *)text) < 40) {
 		/* configures the text */
-		if(*text) {
-			if(widget_button->text)
-				free(widget_button->text);
-			widget_button->text = calloc(1, sizeof(ei_widget_text_t));
-			strcpy(*(widget_button->text), *text);
-		} else
-			widget_button->text = NULL;
-		widget_button->img = NULL;
+		set_text(&widget_button->set, widget_button->text, *text);
+		set_image(&widget_button->set, &widget_button->img, NULL, NULL);
 	} else if(img) {
-		/* configures the image */
-		if(*img) {
-			/* Copy the image */
-			ei_size_t img_size = hw_surface_get_size(*img);
-			if(widget_button->img)
-				free(widget_button->img);
-			else 
-				widget_button->img = malloc(sizeof(ei_surface_t));
-			*(widget_button->img) = hw_surface_create(*img, img_size, EI_FALSE);
-			ei_copy_surface(*(widget_button->img), NULL, *img, NULL, EI_FALSE);
-
-			/* configures the rect */
-			if(img_rect) {
-				if (!widget_button->img_rect)
-					widget_button->img_rect = malloc(sizeof(ei_rect_t));
-				*(widget_button->img_rect) = **img_rect;
-			}
-		} else
-			widget_button->img = NULL;
-		widget_button->text = NULL;
+		/* configures the image and its rect */
+		set_image(&widget_button->set, &widget_button->img, *img, img_rect);
+		set_text(&widget_button->set, widget_button->text, NULL);
 	}
 
-	/* configures the text font */
-	if(!text_font) {
-		if(!widget_button->text_font) {
-			widget_button->text_font = malloc(sizeof(ei_font_t));
-			*(widget_button->text_font) = ei_default_font;
-		}
-	} else
-		*(widget_button->text_font) = *text_font;
-
-	/* configures the text color */
-	if(!text_color) {
-		if(!widget_button->text_color) {
-			widget_button->text_color = malloc(sizeof(ei_color_t));
-			*(widget_button->text_color) = ei_font_default_color;
-		}
-	} else
-		*(widget_button->text_color) = *text_color;
-
-	/* configures the text anchor */
-	if(!text_anchor) {
-		if(!widget_button->text_anchor) {
-			widget_button->text_anchor = malloc(sizeof(ei_anchor_t));
-			*(widget_button->text_anchor) = ei_anc_center;
-		}
-	} else
-		*(widget_button->text_anchor) = *text_anchor;
-
-	/* configures the image anchor */
-	if(!img_anchor) {
-		if(!widget_button->img_anchor) {
-			widget_button->img_anchor = malloc(sizeof(ei_anchor_t));
-			*(widget_button->img_anchor) = ei_anc_center;
-		}
-	} else
-		*(widget_button->img_anchor) = *img_anchor;
+	/* configures the text font, color and anchor, and the image anchor */
+	if(text_font)
+		widget_button->text_font = *text_font;
+	if(text_color)
+		widget_button->text_color = *text_color;
+	if(text_anchor)
+		widget_button->text_anchor = *text_anchor;
+	if(img_anchor)
+		widget_button->img_anchor = *img_anchor;
 
 	/* Binds callback to mouse_down on the button */
-	if(callback) {
-		widget_button->callback = malloc(sizeof(ei_callback_t));
-		*widget_button->callback = *callback;
-	}
-	if(user_param) {
-		widget_button->user_param = malloc(sizeof(void*));
-		*widget_button->user_param = *user_param;
-	}
-	
-
-	/* special parameters : these must be changed AFTER a button_configure() */
-	widget_button->no_clipping = EI_FALSE;
-
-	widget_button->is_quit_button = EI_FALSE;
-	widget_button->is_resize_button = EI_FALSE;
-	
-	if(widget->geom_params) {
-		widget->geom_params->manager->runfunc(widget);
+	if(callback)
+		widget_button->callback = *callback;
+	if(user_param)
+		widget_button->user_param = *user_param;
+
+	/* the special parameters (no_clipping, is_quit_button, is_resize_button) are kept: they
+	   are set by setdefaultsfunc, then by the toplevel for its buttons */
+	if(!widget->geom_params)
+		return;
+	if(relayout(widget, old.widget.requested_size) ||
+	   widget_button->border_width != old.border_width || widget_button->corner_radius != old.corner_radius ||
+	   widget_button->relief != old.relief || !same_color(widget_button->color, old.color) ||
+	   widget_button->no_clipping != old.no_clipping || image_changed(old.set, widget_button->set, img) ||
+	   ((widget_button->set & ei_attr_img) && widget_button->img_anchor != old.img_anchor)) {
 		ei_rect_t inv_rect = extend_rect(widget->screen_location);
-        ei_app_invalidate_rect(&inv_rect);
+		ei_app_invalidate_rect(&inv_rect);
+	} else if(text_changed(old.set, old.text, old.text_font, old.text_color, old.text_anchor,
+			       widget_button->set, widget_button->text, widget_button->text_font, widget_button->text_color, widget_button->text_anchor)) {
+		/* the text only: where it was and where it is */
+		invalidate_text(widget, text_rect(widget, old.set, old.text, old.text_font, old.text_anchor),
+				text_rect(widget, widget_button->set, widget_button->text, widget_button->text_font, widget_button->text_anchor),
+				widget_button->border_width);
 	}
 }
 
@@ -363,6 +332,11 @@ void ei_toplevel_configure(ei_widget_t *widget,
 						   ei_axis_set_t *resizable,
 						   ei_size_t **min_size)
 {
+	/* the attributes before the call: only what changed is drawn again */
+	if(widget->geom_params)
+		ei_geometrymanager_resolve(widget);
+	const ei_toplevel_t old = *(ei_toplevel_t *)widget;
+
 	/* configures requested size */
 	if(requested_size)
 		widget->requested_size = *requested_size;
@@ -372,144 +346,186 @@ void ei_toplevel_configure(ei_widget_t *widget,
 	/* casting the widget (pointer) into a toplevel (pointer) */
 	ei_toplevel_t *widget_toplevel = (ei_toplevel_t *)widget;
 
-	/* configures the color */
-	if(!color) {
-		if(!widget_toplevel->background_color) {
-			widget_toplevel->background_color = malloc(sizeof(ei_color_t));
-			*(widget_toplevel->background_color) = ei_default_background_color;
-		}
-	} else
-		*(widget_toplevel->background_color) = *color;
+	/* configures the color, border width and title (the defaults are set at the creation) */
+	if(color)
+		widget_toplevel->background_color = *color;
+	if(border_width)
+		widget_toplevel->border_width = *border_width;
+	if(title)
+		widget_toplevel->title = *title;
 
-	/* configures the border width */
-	if(!border_width) {
-		if(!widget_toplevel->border_width) {
-			widget_toplevel->border_width = malloc(sizeof(int));
-			*(widget_toplevel->border_width) = 4;
-		}
-	} else
-		*(widget_toplevel->border_width) = *border_width;
+	/* defines if the toplevel is closable or not */
+	if(closable) {
+		widget_toplevel->closable = *closable;
 
-	/* configures the title */
-	if(!title) {
-		if(!widget_toplevel->title) {
-			widget_toplevel->title = malloc(sizeof(char[9]));
-			*(widget_toplevel->title) = "Toplevel";
-		}
-	} else {
-		free(widget_toplevel->title);
-		widget_toplevel->title = malloc(sizeof(*title));
-		*(widget_toplevel->title) = *title;
+		/* if the toplevel is not closable, destroys the quit button (it is unlinked from the children) */
+		if(*closable == EI_FALSE && widget_toplevel->quit_button)
+			ei_widget_destroy(widget_toplevel->quit_button);
 	}
 
-	if(!widget_toplevel->title_font) {
-		widget_toplevel->title_font = malloc(sizeof(ei_font_t));
-		*(widget_toplevel->title_font) = ei_default_font;
+	/* defines if and where the toplevel is sizeable or not */
+	if(resizable) {
+		widget_toplevel->resizable = *resizable;
+
+		/* if the toplevel is not resizable, destroys the resize button (it is unlinked from the children) */
+		if(*resizable == EI_FALSE && widget_toplevel->resize_button)
+			ei_widget_destroy(widget_toplevel->resize_button);
 	}
 
-	/* defines if the toplevel is closable or not */
-	if(!closable) {
-		if(!widget_toplevel->closable) {
-			widget_toplevel->closable = malloc(sizeof(ei_bool_t));
-			*(widget_toplevel->closable) = EI_TRUE;
-		}
-	} else {
-		*(widget_toplevel->closable) = *closable;
-
-		/* if the toplevel is not closable, withdraw the quit button */
-		if(*closable == EI_FALSE) {
-			ei_widget_t * curr = widget->children_head;
-
-			/* if the quit button is at the head (it must be the case) */
-			if(!strcmp(curr->wclass->name,"button") && ((ei_button_t*)curr)->is_quit_button) {
-				/* changes the head */
-				widget->children_head = curr->next_sibling;
-				/* if the quit button was at the head and the tail (i.e. no other siblings) */
-				if(widget->children_tail == curr)
-					widget->children_tail = NULL;
-				
-				ei_widget_destroy(curr);
-			} else { /* the quit button is not at the head : we finds it */
-				while(curr && curr->next_sibling && (strcmp(curr->next_sibling->wclass->name,"button") || 
-				(!strcmp(curr->next_sibling->wclass->name,"button") && !((ei_button_t*)curr->next_sibling)->is_quit_button)) )
-					curr = curr->next_sibling;
-
-				/* checks that it is a quit button : the while loop can end without having 
-				found a quit button if the toplevel already has no quit button */
-				if(curr && curr->next_sibling && !strcmp(curr->next_sibling->wclass->name,"button") 
-				&& ((ei_button_t*)curr->next_sibling)->is_quit_button) {
-					ei_widget_t* quit_button = curr->next_sibling;
-					/* withdraws the quit button from the children list */
-					/* if the quit button is not at the end */
-					if(quit_button->next_sibling) {
-						curr->next_sibling = quit_button->next_sibling;
-					} else { /* if it is at the end */
-						widget->children_tail = curr;
-					}
-					ei_widget_destroy(quit_button);
-				}
-			}
-		}
+	/* configures the minimum size */
+	if(min_size)
+		widget_toplevel->min_size = **min_size;
+
+	if(!widget->geom_params)
+		return;
+	if(relayout(widget, old.widget.requested_size) || widget_toplevel->border_width != old.border_width ||
+	   !same_color(widget_toplevel->background_color, old.background_color)) {
+		ei_rect_t inv_rect = extend_rect(widget_toplevel->draw_rect);
+		ei_app_invalidate_rect(&inv_rect);
+	} else if(title && *title == old.title) {
+		/* the same string, which may have been modified: the title bar right of the close button */
+		ei_rect_t bar = ei_toplevel_title_rect(widget_toplevel, "");
+		bar.size = (ei_size_t){widget_toplevel->draw_rect.top_left.x + widget_toplevel->draw_rect.size.width - bar.top_left.x,
+				       default_topbar_height};
+		ei_app_invalidate_rect(&bar);
+	} else if(title && (!*title || !old.title || strcmp(*title, old.title))) {
+		ei_rect_t old_rect = old.title ? ei_toplevel_title_rect(widget_toplevel, old.title) : ei_rect_zero();
+		ei_rect_t rect = *title ? ei_toplevel_title_rect(widget_toplevel, *title) : ei_rect_zero();
+		rect = get_ei_rect_intersection(get_ei_rect_union(old_rect, rect), widget_toplevel->draw_rect);
+		if(rect.size.width > 0 && rect.size.height > 0)
+			ei_app_invalidate_rect(&rect);
 	}
+}
 
-	/* defines if and where the toplevel is sizeable or not */
-	if(!resizable) {
-		if(!widget_toplevel->resizable) {
-			widget_toplevel->resizable = malloc(sizeof(ei_axis_set_t));
-			*(widget_toplevel->resizable) = ei_axis_both;
-		}
-	} else {
-		*(widget_toplevel->resizable) = *resizable;
-
-		/* if the toplevel is not resizable, withdraw the resize button */
-		if(*resizable == EI_FALSE) {
-			ei_widget_t * curr = widget->children_head;
-
-			/* if the resize button is at the head (it must not be the case) */
-			if(!strcmp(curr->wclass->name,"button") && ((ei_button_t*)curr)->is_resize_button) {
-				/* changes the head */
-				widget->children_head = curr->next_sibling;
-				/* if the resize button was at the head and the tail (i.e. no other siblings) */
-				if(widget->children_tail == curr)
-					widget->children_tail = NULL;
-				ei_widget_destroy(curr);
-			} else { /* the resize button is not at the head : we finds it (it must be at the tail) */
-				while(curr && curr->next_sibling && (strcmp(curr->next_sibling->wclass->name,"button") || 
-				(!strcmp(curr->next_sibling->wclass->name,"button") && !((ei_button_t*)curr->next_sibling)->is_resize_button)) )
-					curr = curr->next_sibling;
-
-				/* checks that it is a resize button : the while loop can end without having 
-				found a resize button if the toplevel already has no resize button */
-				if(curr && curr->next_sibling && !strcmp(curr->next_sibling->wclass->name,"button") 
-				&& ((ei_button_t*)curr->next_sibling)->is_resize_button) {
-					ei_widget_t* resize_button = curr->next_sibling;
-					/* withdraws the resize button from the children list */
-					/* if the resize button is not at the end */
-					if(resize_button->next_sibling) {
-						curr->next_sibling = resize_button->next_sibling;
-					} else { /* if it is at the end (it must be the case)*/
-						widget->children_tail = curr;
-					}
-					ei_widget_destroy(resize_button);
-				}
-			}
+/* inserts a widget in the children of its parent, after previous (at the head if previous is NULL) */
+static void link_child(ei_widget_t *widget, ei_widget_t *previous)
+{
+	ei_widget_t *parent = widget->parent;
+	ei_widget_t *next = previous ? previous->next_sibling : parent->children_head;
+
+	widget->prev_sibling = previous;
+	widget->next_sibling = next;
+	if(previous)
+		previous->next_sibling = widget;
+	else
+		parent->children_head = widget;
+	if(next)
+		next->prev_sibling = widget;
+	else
+		parent->children_tail = widget;
+	ei_geometry_store_link(widget, previous);
+}
+
+/* removes a widget from the children of its parent */
+static void unlink_child(ei_widget_t *widget)
+{
+	ei_widget_t *parent = widget->parent;
+
+	ei_geometry_store_unlink(widget, widget->prev_sibling);
+	if(widget->prev_sibling)
+		widget->prev_sibling->next_sibling = widget->next_sibling;
+	else
+		parent->children_head = widget->next_sibling;
+	if(widget->next_sibling)
+		widget->next_sibling->prev_sibling = widget->prev_sibling;
+	else
+		parent->children_tail = widget->prev_sibling;
+	widget->prev_sibling = NULL;
+	widget->next_sibling = NULL;
+}
+
+/* the child after which a widget is inserted to be drawn above its siblings: the last child, but
+   the resize button of a toplevel stays above its other children */
+static ei_widget_t *top_position(ei_widget_t *parent)
+{
+	if(!strcmp(parent->wclass->name, "toplevel") && ((ei_toplevel_t *)parent)->resize_button)
+		return ((ei_toplevel_t *)parent)->resize_button->prev_sibling;
+	return parent->children_tail;
+}
+
+/* moves a widget among its siblings, after previous (at the head if previous is NULL) */
+static void move_child(ei_widget_t *widget, ei_widget_t *previous)
+{
+	unlink_child(widget);
+	link_child(widget, previous);
+}
+
+/* invalidates where a widget overlaps the siblings it passes over, from first to last: the pixels
+   change nowhere else when the widget goes above or below them */
+static void invalidate_overlaps(ei_widget_t *widget, ei_widget_t *first, ei_widget_t *last)
+{
+	const ei_geometry_store_t *store = ei_geometry_store();
+	const uint32_t slot = widget->pick_id;
+	if((store->flags[slot] & (ei_geometry_mapped | ei_geometry_hidden)) != ei_geometry_mapped)
+		return;
+
+	for(ei_widget_t *sibling = first; sibling; sibling = sibling->next_sibling) {
+		const uint32_t other = sibling->pick_id;
+		if(sibling != widget && (store->flags[other] & (ei_geometry_mapped | ei_geometry_hidden)) == ei_geometry_mapped) {
+			ei_rect_t overlap = get_ei_rect_intersection(store->bounds[slot], store->bounds[other]);
+			/* both are clipped by the content of their parent, unless one of them is not */
+			if(!((store->flags[slot] | store->flags[other]) & ei_geometry_unclipped))
+				overlap = get_ei_rect_intersection(overlap, store->content[widget->parent->pick_id]);
+			if(overlap.size.width > 0 && overlap.size.height > 0)
+				ei_app_invalidate_rect(&overlap);
 		}
+		if(sibling == last)
+			break;
 	}
+}
 
-	/* configures the minimum size */
-	if(!min_size) {
-		if(!widget_toplevel->min_size) {
-			widget_toplevel->min_size = malloc(sizeof(ei_size_t));
-			*(widget_toplevel->min_size) = (ei_size_t){160, 120};
-		}
-	} else
-		*(widget_toplevel->min_size) = **min_size;
+void ei_widget_raise(ei_widget_t *widget)
+{
+	if(!widget->parent)
+		return;
+	ei_widget_t *previous = top_position(widget->parent);
+	if(previous == widget || previous == widget->prev_sibling)
+		return;
+
+	/* the widget goes above the siblings between it and its new place */
+	invalidate_overlaps(widget, widget->next_sibling, previous);
+	move_child(widget, previous);
+}
 
-	if(widget->geom_params) {
-		widget->geom_params->manager->runfunc(widget);
-		ei_rect_t inv_rect = extend_rect(widget->screen_location);
-        ei_app_invalidate_rect(&inv_rect);
+void ei_widget_lower(ei_widget_t *widget)
+{
+	if(!widget->parent || !widget->prev_sibling)
+		return;
+
+	/* the widget goes below the siblings before it */
+	invalidate_overlaps(widget, widget->parent->children_head, widget->prev_sibling);
+	move_child(widget, NULL);
+}
+
+void ei_widget_set_visible(ei_widget_t *widget, ei_bool_t visible)
+{
+	if(!widget->parent || widget->hidden == !visible)
+		return;
+	widget->hidden = !visible;
+	ei_geometrymanager_resolve(widget);
+	ei_geometry_store_update(widget);
+
+	/* the geometry of the subtree is kept: only the pixels it covers change */
+	const ei_geometry_store_t *store = ei_geometry_store();
+	if(store->flags[widget->pick_id] & ei_geometry_mapped) {
+		ei_rect_t bounds = store->bounds[widget->pick_id];
+		ei_app_invalidate_rect(&bounds);
+	}
+}
+
+/* the arena where the children of parent are allocated: the one of its nearest toplevel (created
+   with its first descendant), or the one of the application (NULL) */
+static ei_slab_arena_t *arena_of(ei_widget_t *parent)
+{
+	for(; parent; parent = parent->parent) {
+		if(!strcmp(parent->wclass->name, "toplevel")) {
+			ei_toplevel_t *toplevel = (ei_toplevel_t *)parent;
+			if(!toplevel->arena)
+				toplevel->arena = ei_slab_arena_create();
+			return toplevel->arena;
+		}
 	}
+	return NULL;
 }
 
 ei_widget_t *ei_widget_create(ei_widgetclass_name_t class_name,
@@ -520,13 +536,14 @@ ei_widget_t *ei_widget_create(ei_widgetclass_name_t class_name,
 
 	/* a pointer to the given widget class */
 	ei_widgetclass_t *wclass = ei_widgetclass_from_name(class_name);
-	/* allocates memory depending on the widget class */
-	ei_widget_t *wid = wclass->allocfunc();
+	/* allocates memory depending on the widget class (in its slab, if it has one) */
+	ei_widget_t *wid = ei_slab_alloc(arena_of(parent), wclass);
 
 	/*Copy of wid_id to not alter the orginal */
 	/* sets the widgetclass attributes */
 	wid->wclass = wclass;
-	wid->pick_id = wid_id++;
+	wid->pick_id = ei_picking_register(wid);
+	ei_geometry_store_add(wid);
 	wid->user_data = user_data;
 	wid->destructor = destructor;
 	wid->parent = parent;
@@ -534,166 +551,140 @@ ei_widget_t *ei_widget_create(ei_widgetclass_name_t class_name,
 	/* sets widget's pick color */
 	uint32_t temp_wid_id = wid->pick_id;
 
-	wid->pick_color = calloc(1, sizeof(ei_color_t));
-	wid->pick_color->red = temp_wid_id & 255;
+	wid->pick_color.red = temp_wid_id & 255;
 	temp_wid_id >>= 8;
 	if (temp_wid_id > 0) {
-		wid->pick_color->green = temp_wid_id & 255;
+		wid->pick_color.green = temp_wid_id & 255;
 		temp_wid_id >>= 8;
 		if (temp_wid_id > 0) {
-			wid->pick_color->blue = temp_wid_id & 255;
+			wid->pick_color.blue = temp_wid_id & 255;
 			temp_wid_id >>= 8;
 		}
 	}
-	wid->pick_color->alpha = 255;
-
-	/* manages the widgets (children) if the created widget has a parent (i.e. is not the root) */
-	if(parent) {
-		/* if the parent has children, we add the widget to the children list */
-		ei_bool_t place_at_tail = EI_TRUE;
-		if(!strcmp(parent->wclass->name,"toplevel") && *((ei_toplevel_t*)parent)->resizable && parent->children_head ){
-			ei_widget_t* penultimate = parent->children_head;
-			ei_widget_t* ultimate = penultimate->next_sibling;
-
-			/* if there is only child */
-			if(!ultimate) {
-				parent->children_head = wid;
-				wid->next_sibling = penultimate;
-				place_at_tail = EI_FALSE;
-			} else {
-				/* finds the first resize button of the children, must be the last one */
-				while(strcmp(ultimate->wclass->name,"button") ||
-					(!strcmp(ultimate->wclass->name,"button") && !((ei_button_t*)ultimate)->is_resize_button)){
-					penultimate = penultimate->next_sibling;
-					ultimate = penultimate->next_sibling;
-				}
-
-				/* checks that we are at the tail and it is the resize button */
-				if(ultimate->next_sibling == NULL && parent->children_tail == ultimate 
-				&& !strcmp(ultimate->wclass->name,"button") && ((ei_button_t*)ultimate)->is_resize_button) {
-					penultimate->next_sibling = wid;
-					wid->next_sibling = parent->children_tail;
-					place_at_tail = EI_FALSE;
-				}
-			}
-		}
+	wid->pick_color.alpha = 255;
 
-		if(place_at_tail) {
-			if(parent->children_tail){
-				parent->children_tail->next_sibling = wid;
-			}
-			parent->children_tail = wid;
-			wid->next_sibling = NULL;
+	/* adds the widget above its siblings, if it has a parent (i.e. is not the root) */
+	if(parent)
+		link_child(wid, top_position(parent));
 
-			if(!parent->children_head)
-				parent->children_head = wid;
-		}
-	}
 	/* sets the default attributes of the widget */
 	wclass->setdefaultsfunc(wid);
 	return wid;
 }
 
-void ei_widget_destroy_recurs(ei_widget_t *widget)
+/* destroys a widget and the next siblings, with their descendants, in one pass: the area of the
+   subtree is invalidated once by the caller, and the chunks of the toplevels are released at once */
+static void destroy_subtree(ei_widget_t *widget)
 {
-	/* Removes the widget from the screen if it is currently managed by a geometry manager */
-	if (widget->destructor)
-		widget->destructor(widget);
-
-	/* destroys of the children */
-	ei_widget_t *current_free = widget;
-	ei_widget_t *next;
-	while (current_free)
+	while (widget)
 	{
-		next = current_free->next_sibling;
+		ei_widget_t *next = widget->next_sibling;
 
-		/* destroys children of the children if they have so */
-		if (current_free->children_head)
-			ei_widget_destroy_recurs(current_free->children_head);
+		/* calls the programmer's destructor, then destroys the children */
+		if (widget->destructor)
+			widget->destructor(widget);
+		if (widget->children_head)
+			destroy_subtree(widget->children_head);
 
 		/* calls the release function depending on the widget class */
-		ei_geometrymanager_unmap(current_free);
-		current_free->wclass->releasefunc(current_free);
-		free(current_free->pick_color);
-		free(current_free);
-		current_free = next;
+		ei_geometrymanager_release(widget);
+		widget->wclass->releasefunc(widget);
+		ei_geometry_store_remove(widget);
+		ei_picking_unregister(widget);
+		ei_image_forget_widget(widget);
+		ei_slab_free(widget);
+		widget = next;
 	}
 }
 
 void ei_widget_destroy(ei_widget_t *widget)
 {
-	/* TODO : mathis zizi */
-	ei_app_invalidate_rect(&widget->screen_location);
-	destroy_event_binded_to_widget(widget);
-
-	/* Removes the widget from the screen if it is currently managed by a geometry manager */
-	if (widget->destructor)
-		widget->destructor(widget);
-
-	/* destroys of the children (note that we do not check if the widget has children : 
-	   we must have checked before)*/
-	if (widget->children_head)
-		ei_widget_destroy_recurs(widget->children_head);
-
-	if (widget->parent) {
-		ei_widget_t *last_child = NULL;
-		ei_widget_t *curr_child = widget->parent->children_head;
-		while (curr_child && curr_child != widget) {
-			last_child = curr_child;
-			curr_child = curr_child->next_sibling;
-		}
-
-		if (!last_child && widget->parent->children_tail == curr_child) {
-			widget->parent->children_tail = NULL;
-			widget->parent->children_head = NULL;
-		} else if (!last_child) {
-			widget->parent->children_head = widget->next_sibling;
-		} else if (curr_child == widget->parent->children_tail) {
-			last_child->next_sibling = NULL;
-			widget->parent->children_tail = last_child;
-		} else
-			last_child->next_sibling = curr_child->next_sibling;
+	/* what the subtree covers is drawn again (its descendants are clipped by it) */
+	const ei_geometry_store_t *store = ei_geometry_store();
+	if (store->flags[widget->pick_id] & ei_geometry_mapped) {
+		ei_rect_t covered = store->bounds[widget->pick_id];
+		ei_app_invalidate_rect(&covered);
 	}
 
-	/* calls the release function depending on the widget class */
-	ei_geometrymanager_unmap(widget);
-	widget->wclass->releasefunc(widget);
-	free(widget->pick_color);
-	free(widget);
+	/* the events binded to the subtree, in one pass over the bindings */
+	destroy_event_binded_to_subtree(widget);
+
+	if (widget->parent)
+		unlink_child(widget);
+	widget->next_sibling = NULL;
+	destroy_subtree(widget);
 }
 
-ei_widget_t *ei_widget_pick_rec(ei_widget_t *parent, uint32_t pick_color, ei_surface_t pick_surface)
+ei_widget_t *ei_widget_pick(ei_point_t *where)
 {
-	/* Checks if the parent matches */
-	if (pick_color == ei_map_rgba(pick_surface, parent->pick_color))
-		return parent;
-
-	/* Navigator through the parent's direct children */
-	ei_widget_t *curr_test = parent->children_head;
-	/* Go through the parent's direct children linked list */
-	while (curr_test) {
-		/* Try to find the matching widget */
-		ei_widget_t *ret = ei_widget_pick_rec(curr_test, pick_color, pick_surface);
-
-		/* If it is found, return it */
-		if (ret)
-			return ret;
-
-		/* Else continue */
-		curr_test = curr_test->next_sibling;
+	/* Returns found widget (pick surface or geometric hit testing, depending on the mode) */
+	return ei_picking_find(*where);
+}
+
+void ei_viewer_configure(ei_widget_t *widget,
+						 ei_size_t *requested_size,
+						 const ei_color_t *color,
+						 char **filename,
+						 int *level,
+						 ei_point_t *offset) {
+	/* configures requested size */
+	if(requested_size)
+		widget->requested_size = *requested_size;
+	else if(widget->requested_size.width == 0 && widget->requested_size.height == 0)
+		widget->requested_size = (ei_size_t){320, 240};
+
+	/* casting the widget (pointer) into a viewer (pointer) */
+	ei_viewer_t *widget_viewer = (ei_viewer_t *)widget;
+
+	/* configures the color */
+	if(color)
+		widget_viewer->color = *color;
+
+	/* configures the image: the pyramid is built on the first opening of the image */
+	if(filename) {
+		if(widget_viewer->pyramid)
+			ei_tiles_close(widget_viewer->pyramid);
+		widget_viewer->pyramid = *filename ? ei_tiles_open(*filename, ei_app_root_surface()) : NULL;
+
+		/* the first level which fits in the widget */
+		widget_viewer->level = 0;
+		if(widget_viewer->pyramid) {
+			const int levels_nb = ei_tiles_levels(widget_viewer->pyramid);
+			while(widget_viewer->level < levels_nb - 1) {
+				ei_size_t size = ei_tiles_level_size(widget_viewer->pyramid, widget_viewer->level);
+				if(size.width <= widget->requested_size.width && size.height <= widget->requested_size.height)
+					break;
+				widget_viewer->level++;
+			}
+		}
 	}
+	if(level && widget_viewer->pyramid)
+		widget_viewer->level = max(0, min(*level, ei_tiles_levels(widget_viewer->pyramid) - 1));
+
+	/* centers the level unless an offset is given */
+	if(offset)
+		widget_viewer->offset = *offset;
+	else if((filename || level) && widget_viewer->pyramid) {
+		ei_size_t size = ei_tiles_level_size(widget_viewer->pyramid, widget_viewer->level);
+		widget_viewer->offset = (ei_point_t){(size.width - widget->requested_size.width) / 2,
+						     (size.height - widget->requested_size.height) / 2};
+	}
+	ei_viewer_clamp_offset(widget_viewer);
 
-	/* If no widget was found, returns NULL */
-	return NULL;
+	if(widget->geom_params) {
+		widget->geom_params->manager->runfunc(widget);
+		ei_rect_t inv_rect = extend_rect(widget->screen_location);
+        ei_app_invalidate_rect(&inv_rect);
+	}
 }
 
-ei_widget_t *ei_widget_pick(ei_point_t *where)
-{
-	/* Gets the pick_surface's pixel colot under the mouse */
-	uint32_t *pixel_ptr = (uint32_t *)hw_surface_get_buffer(pick_surface);
-	ei_size_t pick_size = hw_surface_get_size(pick_surface);
-	pixel_ptr += where->x + where->y * pick_size.width;
 
-	/* Returns found widget */
-	return ei_widget_pick_rec(ei_app_root_widget(), *pixel_ptr, pick_surface);
+void ei_widget_set_image_scaling(ei_widget_t* widget, const ei_image_scaling_t* scaling) {
+	if(!strcmp(widget->wclass->name, "frame"))
+		set_image_scaling(&((ei_frame_t*)widget)->set, &((ei_frame_t*)widget)->img_scaling, scaling);
+	else if(!strcmp(widget->wclass->name, "button"))
+		set_image_scaling(&((ei_button_t*)widget)->set, &((ei_button_t*)widget)->img_scaling, scaling);
+	else
+		return;
+	ei_app_invalidate_rect(&widget->screen_location);
 }
@@ -8,6 +8,8 @@
 #include "ei_frameclass.h"
 #include "ei_buttonclass.h"
 #include "ei_toplevelclass.h"
+#include "ei_viewerclass.h"
+#include "ei_slab.h"
 
 ei_widgetclass_t *widclss_top = NULL;
 
@@ -53,8 +55,9 @@ void ei_frame_register_class(void) {
 	frame_class->setdefaultsfunc = setdefaultsframe;
 	frame_class->geomnotifyfunc = geomnotifyframe;
 
-	/* registers the widgetclass that has been defined above */
+	/* registers the widgetclass that has been defined above, its widgets are allocated in slabs */
 	ei_widgetclass_register(frame_class);
+	ei_slab_register(ei_widgetclass_from_name("frame"), sizeof(ei_frame_t));
 }
 
 
@@ -70,8 +73,9 @@ void ei_button_register_class(void) {
 	button_class->setdefaultsfunc = setdefaultsbutton;
 	button_class->geomnotifyfunc = geomnotifybutton;
 
-	/* registers the widgetclass that has been defined above */
+	/* registers the widgetclass that has been defined above, its widgets are allocated in slabs */
 	ei_widgetclass_register(button_class);
+	ei_slab_register(ei_widgetclass_from_name("button"), sizeof(ei_button_t));
 }
 
 
@@ -87,6 +91,25 @@ void ei_toplevel_register_class(void) {
 	toplevel_class->setdefaultsfunc = setdefaultstoplevel;
 	toplevel_class->geomnotifyfunc = geomnotifytoplevel;
 
-	/* registers the widgetclass that has been defined above */
+	/* registers the widgetclass that has been defined above, its widgets are allocated in slabs */
 	ei_widgetclass_register(toplevel_class);
+	ei_slab_register(ei_widgetclass_from_name("toplevel"), sizeof(ei_toplevel_t));
+}
+
+
+void ei_viewer_register_class(void) {
+	/* dynamically allocates memory for the widgetclass to add */
+	ei_widgetclass_t *viewer_class = calloc(1,sizeof(ei_widgetclass_t));
+
+	/* defines all the attributes of the widgetclass 'viewer' */
+	strcpy((char*)viewer_class->name, "viewer");
+	viewer_class->allocfunc = allocviewer;
+	viewer_class->releasefunc = releaseviewer;
+	viewer_class->drawfunc = drawviewer;
+	viewer_class->setdefaultsfunc = setdefaultsviewer;
+	viewer_class->geomnotifyfunc = geomnotifyviewer;
+
+	/* registers the widgetclass that has been defined above, its widgets are allocated in slabs */
+	ei_widgetclass_register(viewer_class);
+	ei_slab_register(ei_widgetclass_from_name("viewer"), sizeof(ei_viewer_t));
 }
@@ -16,6 +16,8 @@
 #include "ei_utils.h"
 #include "ei_event.h"
 #include "ei_geometrymanager.h"
+#include "ei_atlas.h"
+#include "ei_batch.h"
 
 /* constants */
 
@@ -23,8 +25,9 @@ static const int BUTTON_SIZE = 28;
 
 /* global resources */
 
-static ei_surface_t		glob_flag_img;
-static ei_surface_t		glob_bomb_img;
+static ei_atlas_t*		glob_icons;
+static ei_rect_t*		glob_flag_rect;
+static ei_rect_t*		glob_bomb_rect;
 static ei_surface_t		glob_reset_img;
 
 /* structs & typedefs */
@@ -140,7 +143,7 @@ void switch_flag(map_pos_t* map_pos)
 
 	if (map_pos->has_flag) {
 		ei_frame_configure(map_pos->frame_w, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-								NULL, &glob_flag_img, NULL, NULL);
+								NULL, &glob_icons->surface, &glob_flag_rect, NULL);
 		map_pos->map_ptr->flag_count--;
 	} else {
 		ei_frame_configure(map_pos->frame_w, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
@@ -166,7 +169,7 @@ void reveal_position_no_check(map_pos_t* map_pos)
 										NULL, NULL, NULL);
 	if (map_pos->has_mine) {
 		ei_frame_configure(map_pos->frame_w, NULL, NULL, NULL, &relief, NULL, NULL,
-							NULL, NULL, &glob_bomb_img, NULL, NULL);
+							NULL, NULL, &glob_icons->surface, &glob_bomb_rect, NULL);
 		return;
 	}
 
@@ -273,6 +276,8 @@ void reset_game(map_t* map)
 	map->flag_count = map->nb_mines;
 	map->game_over = EI_FALSE;
 	map->nb_revealed = 0;
+	/* the squares are redrawn once, after all of them are reset */
+	ei_batch_begin();
 	for (i = 0; i < map->width * map->height; i++) {
 		map->map_pos[i].has_mine = EI_FALSE;
 		map->map_pos[i].has_flag = EI_FALSE;
@@ -286,6 +291,7 @@ void reset_game(map_t* map)
 	update_flag_count(map);
 	ei_frame_configure(map->victory_text_widget, NULL, &color, NULL, NULL, &nulltext, NULL, NULL,
 			NULL, NULL, NULL, NULL);
+	ei_batch_commit();
 }
 
 /*
@@ -494,18 +500,29 @@ int main(int argc, char* argv[])
 	ei_app_create(root_window_size, fullscreen);
 	ei_frame_configure(ei_app_root_widget(), NULL, &root_bgcol, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
 
-	if ((glob_flag_img = hw_image_load("misc/flag.png", ei_app_root_surface())) == NULL) {
+	/* the icons are packed in one surface */
+	glob_icons = ei_atlas_create();
+	int flag_index, bomb_index;
+	if ((flag_index = ei_atlas_add_file(glob_icons, "misc/flag.png")) < 0) {
 		printf("ERROR: could not load image \"misc/flag.png\"");
 	return 1;
 	}
-	if ((glob_bomb_img = hw_image_load("misc/bomb.png", ei_app_root_surface())) == NULL) {
+	if ((bomb_index = ei_atlas_add_file(glob_icons, "misc/bomb.png")) < 0) {
 		printf("ERROR: could not load image \"misc/bomb.png\"");
 	return 1;
 	}
+	if (!ei_atlas_build(glob_icons)) {
+		printf("ERROR: could not build the atlas of the icons");
+		return 1;
+	}
+	glob_flag_rect = ei_atlas_rect(glob_icons, flag_index);
+	glob_bomb_rect = ei_atlas_rect(glob_icons, bomb_index);
 	glob_reset_img = NULL;
 
 	create_mine_map(&map, size_w, size_h, nb_mines);
+	ei_batch_begin();
 	create_game_window(&map);
+	ei_batch_commit();
 	
 	ei_bind(ei_ev_keydown, NULL, "all", handle_keydown, NULL);
 
@@ -513,8 +530,7 @@ int main(int argc, char* argv[])
 
 	destroy_mine_map(&map);
 
-	hw_surface_free(glob_flag_img);
-	hw_surface_free(glob_bomb_img);
+	ei_atlas_free(glob_icons);
 
 	ei_app_free();
 
@@ -16,6 +16,8 @@
 #include "ei_utils.h"
 #include "ei_event.h"
 #include "ei_geometrymanager.h"
+#include "ei_surface.h"
+#include "ei_image.h"
 
 
 static const int		k_tile_size			= 128;
@@ -125,7 +127,7 @@ void create_puzzle_window(char* image_filename)
 	puzzle_t*		puzzle;
 	tile_t*			tile;
 
-	image		= hw_image_load(image_filename, ei_app_root_surface());
+	image		= ei_image_load(image_filename);
 	image_size	= hw_surface_get_size(image);
 	n		= ei_size(image_size.width / k_tile_size, image_size.height / k_tile_size);
 
@@ -169,7 +171,7 @@ void create_puzzle_window(char* image_filename)
 		}
 	}
 
-	hw_surface_free(image);
+	ei_surface_release(image);
 }
 
 
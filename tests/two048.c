@@ -357,7 +357,7 @@ void destroy_notify	(ei_widget_t*		widget)
 
 	free((void*)(g->tile_values));
 	free((void*)(g->tile_widgets));		// The widget themselves are destroyed as children of the toplevel.
-	hw_text_font_free(g->tile_font);
+	ei_font_free(g->tile_font);
 	free((void*)g);
 }
 